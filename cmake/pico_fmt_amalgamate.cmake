@@ -0,0 +1,60 @@
+# Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+# SPDX-License-Identifier: BSD-3-Clause
+
+# Concatenate pico_fmt's printf in to the single header OUTPUT, with
+# every function `static inline` so that the compiler can see all of it
+# from wherever it's included.  Run as
+#
+#     cmake -DSOURCE_DIR=path/to/pico_fmt -DOUTPUT=path/to/pico_fmt.h -P pico_fmt_amalgamate.cmake
+
+if (NOT SOURCE_DIR OR NOT OUTPUT)
+    message(FATAL_ERROR "pico_fmt_amalgamate.cmake: SOURCE_DIR and OUTPUT must be set")
+endif()
+
+# in dependency order, so that the includes between them can go
+set(inputs
+    include/pico/fmt_printf.h
+    include/pico/fmt_install.h
+    include/pico/fmt_maxlen.h
+    printf_internal.h
+    printf.c
+    printf_float.c
+    convenience.c
+)
+
+set(content "\
+// Generated by pico_fmt_amalgamate.cmake from pico_fmt's printf; do not edit.
+//
+// Each translation unit that includes this gets its own copy of
+// everything it uses, including the default locale that fmt_install()
+// installs in to.  It may be included alongside <pico/fmt_printf.h>
+// (so long as it comes first), but not linked with the pico_fmt
+// library.
+
+#ifndef _PICO_FMT_H
+#define _PICO_FMT_H
+
+// <pico/fmt_printf.h> (which pico_fmt's other headers include) declares
+// everything non-static, which the definitions below can't follow.
+#ifdef _PICO_FMT_PRINTF_H
+#error \"pico_fmt.h must be included before <pico/fmt_printf.h> and pico_fmt's other headers\"
+#endif
+
+#define PICO_FMT_AMALGAMATED 1
+#define PICO_FMT_API static inline
+")
+foreach(input IN LISTS inputs)
+    file(READ "${SOURCE_DIR}/${input}" text)
+    string(REGEX REPLACE "\n#include \"[^\"]*\"" "\n" text "${text}")
+    string(APPEND content "\n// ${input} ////////////////////////////////////////\n\n${text}")
+endforeach()
+string(APPEND content "\n#endif // _PICO_FMT_H\n")
+
+# don't touch OUTPUT if it hasn't changed, so as to not rebuild everything that includes it
+if (EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" old)
+    if (old STREQUAL content)
+        return()
+    endif()
+endif()
+file(WRITE "${OUTPUT}" "${content}")
@@ -0,0 +1,553 @@
+#!/usr/bin/env python3
+# Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+# SPDX-License-Identifier: BSD-3-Clause
+
+"""Generate specialized C formatting functions from a manifest of formats.
+
+Each line of the manifest declares one function:
+
+    # comment
+    NAME TYPE... "FORMAT"
+
+where each TYPE is an `enum fmt_type` without its `FMT_TYPE_` prefix
+(INT, UINT32, STR, ...), giving the function's arguments in order, and
+FORMAT is a printf format written as a C string literal.  For each
+line, NAME.h declares
+
+    int NAME(struct fmt_sink *sink, TYPE a1, ...);
+    int NAME_snprintf(char *buffer, size_t count, TYPE a1, ...);
+    #define NAME_MAXLEN ...
+
+where NAME_MAXLEN is the most that NAME can print, not counting the
+NUL (see <pico/fmt_maxlen.h>); it is left out if that is unbounded (a
+"%s" without a precision, or a "*" width or precision).
+
+The format is parsed here, at build time, exactly as printf.c would
+parse it at run time; the generated code just makes the calls that
+fmt_vfctprintf() would have made, with the literal text between
+directives written as whole chunks.  Types are checked against the
+directives the same way fmt_fctprintf_args() does, and a mismatch is a
+build error.
+
+Usage: pico_fmt_codegen.py MANIFEST OUTDIR
+"""
+
+from __future__ import annotations
+
+import os
+import re
+import sys
+import typing
+
+# enum fmt_type -> C type
+TYPES = {
+    "INT":    "int",
+    "UINT":   "unsigned int",
+    "LONG":   "long",
+    "ULONG":  "unsigned long",
+    "LLONG":  "long long",
+    "ULLONG": "unsigned long long",
+    "INT8":   "int8_t",
+    "UINT8":  "uint8_t",
+    "INT16":  "int16_t",
+    "UINT16": "uint16_t",
+    "INT32":  "int32_t",
+    "UINT32": "uint32_t",
+    "INT64":  "int64_t",
+    "UINT64": "uint64_t",
+    "SIZE":   "size_t",
+    "CHAR":   "char",
+    "FLOAT":  "float",
+    "DOUBLE": "double",
+    "STR":    "const char *",
+    "PTR":    "const void *",
+}
+INTEGERS = {t for t in TYPES if t not in ("FLOAT", "DOUBLE", "STR", "PTR")}
+# types that C guarantees are no wider than an unsigned int
+NARROW = {"INT", "UINT", "CHAR", "INT8", "UINT8", "INT16", "UINT16"}
+SIGNED = {"INT", "LONG", "LLONG", "INT8", "INT16", "INT32", "INT64"}
+
+
+def type_sign(typ: str) -> str:
+    """Whether an integer type is signed, as a C expression."""
+    if typ == "CHAR":
+        return "((char) -1 < 0)"
+    return "true" if typ in SIGNED else "false"
+
+
+def int_value(a: str, typ: str, conv: str) -> str:
+    """The value of the integer argument a, for conv, as printf would
+    have it."""
+    conv_sign = "true" if conv == "CONV_SINT" else "false"
+    return f"_fmt_int_value((unsigned long long) {a}, sizeof({a}), {type_sign(typ)}, {conv_sign})"
+
+
+CONVS: dict[str, str] = {
+    "d": "CONV_SINT", "i": "CONV_SINT",
+    "u": "CONV_UINT", "x": "CONV_UINT", "X": "CONV_UINT", "o": "CONV_UINT", "b": "CONV_UINT",
+    "f": "CONV_DOUBLE", "F": "CONV_DOUBLE", "e": "CONV_DOUBLE", "E": "CONV_DOUBLE",
+    "g": "CONV_DOUBLE", "G": "CONV_DOUBLE",
+    "c": "CONV_CHAR",
+    "s": "CONV_STR",
+    "p": "CONV_PTR",
+    "%": "CONV_PCT",
+}
+
+FLAGS = {"-": "FMT_FLAG_LEFT", "+": "FMT_FLAG_PLUS", " ": "FMT_FLAG_SPACE", "#": "FMT_FLAG_HASH"}
+
+
+class ManifestError(Exception):
+    pass
+
+
+class Directive(typing.NamedTuple):
+    flags: list[str]
+    width: int | str    # int, or "*"
+    precision: int | str
+    specifier: str
+
+
+def suits(typ: str, conv: str) -> bool:
+    """Mirror of _fmt_type_suits()."""
+    if conv in ("CONV_SINT", "CONV_UINT", "CONV_CHAR"):
+        return typ in INTEGERS
+    if conv == "CONV_DOUBLE":
+        return typ in ("FLOAT", "DOUBLE")
+    if conv == "CONV_STR":
+        return typ == "STR"
+    if conv == "CONV_PTR":
+        return typ in ("PTR", "STR")
+    return False
+
+
+def parse_directive(fmt: str, i: int) -> tuple[Directive, int]:
+    """Parse the directive just after the '%' at fmt[i-1], the same way
+    as printf.c's _parse(); return it and the index just past it."""
+    flags: list[str] = []
+    width: int | str = 0
+    precision: int | str = 0
+    state = "flags"
+    while True:
+        if i == len(fmt):
+            raise ManifestError("format ends in the middle of a directive")
+        c = fmt[i]
+        if c in FLAGS and state == "flags":
+            if FLAGS[c] not in flags:
+                flags.append(FLAGS[c])
+        elif c == "0" and state == "flags":
+            if "FMT_FLAG_ZEROPAD" not in flags:
+                flags.append("FMT_FLAG_ZEROPAD")
+        elif c.isdigit() and state == "flags":
+            m = re.match(r"[0-9]+", fmt[i:])
+            assert m
+            width = int(m.group(0))
+            i += len(m.group(0))
+            state = "width"
+            continue
+        elif c == "*" and state == "flags":
+            width = "*"
+            state = "width"
+        elif c == "." and state in ("flags", "width"):
+            flags.append("FMT_FLAG_PRECISION")
+            state = "dot"
+        elif c.isdigit() and state == "dot":
+            m = re.match(r"[0-9]+", fmt[i:])
+            assert m
+            precision = int(m.group(0))
+            i += len(m.group(0))
+            state = "prec"
+            continue
+        elif c == "*" and state == "dot":
+            precision = "*"
+            state = "prec"
+        elif c in "lhtjz":
+            # the length is ignored; each argument's type stands in for it
+            if c in "lh" and fmt[i+1:i+2] == c:
+                i += 1
+            i += 1
+            if i == len(fmt):
+                raise ManifestError("format ends in the middle of a directive")
+            return Directive(flags, width, precision, fmt[i]), i + 1
+        else:
+            return Directive(flags, width, precision, c), i + 1
+        i += 1
+
+
+def c_string(s: str) -> str:
+    out = '"'
+    for ch in s:
+        if ch in '"\\':
+            out += "\\" + ch
+        elif ch == "\n":
+            out += "\\n"
+        elif ch == "\t":
+            out += "\\t"
+        elif " " <= ch <= "~":
+            out += ch
+        else:
+            out += "\\%03o" % ord(ch)
+    # keep "??x" from being read as a trigraph
+    return out.replace("??", '?""?') + '"'
+
+
+def c_char(ch: str) -> str:
+    return {"'": "'\\''", "\\": "'\\\\'", "\n": "'\\n'", "\t": "'\\t'"}.get(
+        ch, f"'{ch}'" if " " <= ch <= "~" else "'\\%03o'" % ord(ch))
+
+
+def decl(ctype: str, name: str) -> str:
+    return f"{ctype}{name}" if ctype.endswith("*") else f"{ctype} {name}"
+
+
+def unescape(lit: str) -> str:
+    return lit.encode("latin-1").decode("unicode_escape")
+
+
+class Formatter:
+    def __init__(self, name: str, types: list[str], fmt: str) -> None:
+        self.name = name
+        self.types = types
+        self.fmt = fmt
+        self.body: list[str] = []
+        # the terms of NAME_MAXLEN, or None if it is unbounded
+        self.maxlen: list[str] | None = []
+
+    def params(self) -> str:
+        return "".join(f", {decl(TYPES[t], f'a{n+1}')}" for n, t in enumerate(self.types))
+
+    def lit(self, text: str) -> None:
+        if len(text) == 1:
+            self.body.append(f"    out({c_char(text)}, &o->ctx);")
+        elif text:
+            self.body.append(f"    _gen_lit(o, {c_string(text)}, {len(text)});")
+
+    def compile(self) -> None:
+        args = iter(enumerate(self.types, 1))
+
+        def take(conv: str, what: str) -> tuple[str, str]:
+            try:
+                n, typ = next(args)
+            except StopIteration:
+                raise ManifestError(f"not enough arguments for {what}")
+            if not suits(typ, conv):
+                raise ManifestError(f"argument {n} ({typ}) doesn't suit {what}")
+            return f"a{n}", typ
+
+        text = ""
+        i = 0
+        while i < len(self.fmt):
+            if self.fmt[i] != "%":
+                text += self.fmt[i]
+                i += 1
+                continue
+            start = i
+            d, i = parse_directive(self.fmt, i + 1)
+            what = repr(self.fmt[start:i])
+            if d.specifier not in CONVS:
+                raise ManifestError(f"{what} is not a built-in specifier")
+            conv = CONVS[d.specifier]
+            if conv == "CONV_PCT":
+                # no arguments, no padding; stars are still consumed
+                for star in (d.width, d.precision):
+                    if star == "*":
+                        take("CONV_SINT", what)
+                text += "%"
+                continue
+            self.lit(text)
+            self.maxlen_lit(text)
+            text = ""
+
+            stars = []
+            if d.width == "*":
+                stars.append(f"        _fmt_set_width(&state, (int) {take('CONV_SINT', what)[0]});")
+            if d.precision == "*":
+                stars.append(f"        _fmt_set_precision(&state, (int) {take('CONV_SINT', what)[0]});")
+            a, typ = take(conv, what)
+            self.maxlen_directive(d, typ)
+
+            if not d.flags and not d.width and typ in NARROW | {"INT32", "UINT32"}:
+                fast = self.fast(d.specifier, a, typ)
+                if fast:
+                    self.body.extend(fast)
+                    continue
+
+            if conv in ("CONV_SINT", "CONV_UINT"):
+                # as printf would if given the argument's type
+                value = f".u = {int_value(a, typ, conv)}"
+            elif conv == "CONV_CHAR":
+                value = f".i = {a}"
+            else:
+                value = {"CONV_DOUBLE": ".f", "CONV_STR": ".s", "CONV_PTR": ".p"}[conv] + f" = {a}"
+            self.body += [
+                "    {",
+                "        struct fmt_state state = {",
+                f"            .flags     = {' | '.join(d.flags) or '0U'},",
+                f"            .width     = {0 if d.width == '*' else d.width}U,",
+                f"            .precision = {0 if d.precision == '*' else d.precision}U,",
+                "            .size      = FMT_SIZE_DEFAULT,",
+                f"            .specifier = '{d.specifier}',",
+                "            .args      = NULL,",
+                "            .ctx       = &o->ctx,",
+                "        };",
+                *stars,
+                f"        _fmt_convert(&state, {conv}, (union _fmt_value){{ {value} }});",
+                "    }",
+            ]
+        self.lit(text)
+        self.maxlen_lit(text)
+        if next(args, None) is not None:
+            raise ManifestError("too many arguments for the format")
+
+    def maxlen_lit(self, text: str) -> None:
+        if self.maxlen is not None and text:
+            self.maxlen.append(f"{len(text)}U")
+
+    def maxlen_directive(self, d: Directive, typ: str) -> None:
+        if self.maxlen is None:
+            return
+        if d.width == "*" or d.precision == "*" or (d.specifier == "s" and "FMT_FLAG_PRECISION" not in d.flags):
+            self.maxlen = None
+            return
+        bits = f"sizeof({TYPES[typ]}) * CHAR_BIT" if typ in INTEGERS else "0U"
+        self.maxlen.append(f"FMT_MAXLEN_DIRECTIVE('{d.specifier}', {' | '.join(d.flags) or '0U'}, "
+                           f"{d.width}U, {d.precision}U, {bits})")
+
+    def fast(self, specifier: str, a: str, typ: str) -> list[str] | None:
+        """The same fast paths that fmt_vfctprintf() takes for bare
+        directives."""
+        if specifier in "di":
+            if typ in ("UINT", "UINT32"):
+                # may be too big for an int
+                return None
+            if typ in SIGNED:
+                call = f"_fast_dec(&o->ctx, (int) {a} < 0 ? 0U - (unsigned int) {a} : (unsigned int) {a}, (int) {a} < 0);"
+            elif typ == "CHAR":
+                # signed or not depending on the target; through an int,
+                # so that there's no always-false comparison where it's
+                # unsigned
+                return [
+                    "    {",
+                    f"        const int v = {a};",
+                    "        _fast_dec(&o->ctx, v < 0 ? 0U - (unsigned int) v : (unsigned int) v, v < 0);",
+                    "    }",
+                ]
+            else:
+                call = f"_fast_dec(&o->ctx, (unsigned int) {a}, false);"
+        elif specifier in "uxX":
+            v = f"(unsigned int) {int_value(a, typ, 'CONV_UINT')}"
+            if specifier == "u":
+                call = f"_fast_dec(&o->ctx, {v}, false);"
+            else:
+                call = f"_fast_hex(&o->ctx, {v}, {'true' if specifier == 'X' else 'false'});"
+        elif specifier == "c":
+            return [f"    out((char) {a}, &o->ctx);"]
+        else:
+            return None
+        if typ in NARROW:
+            return [f"    {call}"]
+        # INT32 and UINT32, only where they fit in an unsigned int
+        return [
+            f"    if (sizeof({a}) <= sizeof(unsigned int)) {{",
+            f"        {call}",
+            "    } else {",
+            "        struct fmt_state state = {",
+            "            .size      = FMT_SIZE_DEFAULT,",
+            f"            .specifier = '{specifier}',",
+            "            .ctx       = &o->ctx,",
+            "        };",
+            f"        _fmt_convert(&state, {CONVS[specifier]}, (union _fmt_value){{ .u = {int_value(a, typ, CONVS[specifier])} }});",
+            "    }",
+        ]
+
+
+def parse_manifest(path: str) -> list[Formatter]:
+    formatters = []
+    names = set()
+    with open(path, encoding="utf-8") as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            where = f"{path}:{lineno}"
+            m = re.fullmatch(r'([A-Za-z_][A-Za-z0-9_]*)((?:\s+[A-Z0-9]+)*)\s+"((?:[^"\\]|\\.)*)"', line)
+            if not m:
+                raise ManifestError(f'{where}: expected NAME TYPE... "FORMAT"')
+            name, types, fmt = m.group(1), m.group(2).split(), unescape(m.group(3))
+            if name in names:
+                raise ManifestError(f"{where}: {name} is declared twice")
+            names.add(name)
+            for t in types:
+                if t not in TYPES:
+                    raise ManifestError(f"{where}: {t} is not an enum fmt_type")
+            fmtr = Formatter(name, types, fmt)
+            try:
+                fmtr.compile()
+            except ManifestError as e:
+                raise ManifestError(f"{where}: {name}: {e}")
+            formatters.append(fmtr)
+    return formatters
+
+
+HEADER_PRE = """\
+// Generated by pico_fmt_codegen.py from {manifest}; do not edit.
+
+#ifndef {guard}
+#define {guard}
+
+#include <limits.h>  /* for CHAR_BIT */
+#include <stddef.h>  /* for size_t */
+#include <stdint.h>  /* for {{u,}}int{{8,16,32,64}}_t */
+
+#include "pico/fmt_maxlen.h"
+#include "pico/fmt_sink.h"
+
+#ifdef __cplusplus
+extern "C" {{
+#endif
+"""
+
+HEADER_POST = """
+#ifdef __cplusplus
+}}
+#endif
+
+#endif // {guard}
+"""
+
+SOURCE_PRE = """\
+// Generated by pico_fmt_codegen.py from {manifest}; do not edit.
+
+#include <string.h>
+
+#include "{name}.h"
+#include "printf_internal.h"
+
+// Output //////////////////////////////////////////////////////////////////////
+//
+// Conversions write to o->ctx a character at a time, and literals are
+// written a chunk at a time; both go in to o->buf, which is either
+// staging for a sink (and passed on whenever it fills) or the caller's
+// snprintf buffer (and anything past the end of it is dropped).
+
+struct _gen_out {{
+    struct _fmt_ctx      ctx;
+    struct fmt_sink     *sink;
+    char                *buf;
+    size_t               cap;
+    size_t               len;
+}};
+
+static void _gen_flush(struct _gen_out *o) {{
+    if (o->sink && o->len) {{
+        o->sink->write(o->sink, o->buf, o->len);
+        o->len = 0;
+    }}
+}}
+
+static void _gen_putc(char character, void *arg) {{
+    struct _gen_out *o = arg;
+    if (o->len == o->cap) {{
+        _gen_flush(o);
+    }}
+    if (o->len < o->cap) {{
+        o->buf[o->len++] = character;
+    }}
+}}
+
+static void _gen_lit(struct _gen_out *o, const char *lit, size_t len) {{
+    o->ctx.idx += len;
+    if (o->sink && o->len + len > o->cap) {{
+        _gen_flush(o);
+        if (len > o->cap) {{
+            o->sink->write(o->sink, lit, len);
+            return;
+        }}
+    }}
+    if (len > o->cap - o->len) {{
+        len = o->cap - o->len;
+    }}
+    memcpy(&o->buf[o->len], lit, len);
+    o->len += len;
+}}
+
+static void _gen_init(struct _gen_out *o, struct fmt_sink *sink, char *buf, size_t cap) {{
+    o->ctx = (struct _fmt_ctx){{
+        .fct = _gen_putc,
+        .arg = o,
+        .idx = 0,
+    }};
+    o->sink = sink;
+    o->buf = buf;
+    o->cap = cap;
+    o->len = 0;
+}}
+
+// Formatters //////////////////////////////////////////////////////////////////
+"""
+
+
+def generate(manifest: str, outdir: str) -> None:
+    name = os.path.splitext(os.path.basename(manifest))[0]
+    if not re.fullmatch(r"[A-Za-z_][A-Za-z0-9_]*", name):
+        raise ManifestError(f"{manifest}: the file name must be a C identifier")
+    formatters = parse_manifest(manifest)
+    guard = f"_{name.upper()}_H"
+    rel = os.path.basename(manifest)
+
+    h = [HEADER_PRE.format(manifest=rel, guard=guard).rstrip("\n")]
+    for f in formatters:
+        h.append(f"\n// {c_string(f.fmt)}")
+        h.append(f"int {f.name}(struct fmt_sink *sink{f.params()});")
+        h.append(f"int {f.name}_snprintf(char *buffer, size_t count{f.params()});")
+        if f.maxlen is not None:
+            h.append(f"#define {f.name}_MAXLEN ({' + '.join(f.maxlen) or '0U'})")
+    h.append(HEADER_POST.format(guard=guard))
+
+    c = [SOURCE_PRE.format(manifest=rel, name=name).rstrip("\n")]
+    for f in formatters:
+        call = "".join(f", a{n+1}" for n in range(len(f.types)))
+        c += [
+            f"\n// {c_string(f.fmt)}",
+            f"static void _{f.name}(struct _gen_out *o{f.params()}) {{",
+            *f.body,
+            "}",
+            "",
+            f"int {f.name}(struct fmt_sink *sink{f.params()}) {{",
+            "    char buf[PICO_PRINTF_SINK_BUFFER_SIZE];",
+            "    struct _gen_out o;",
+            "    _gen_init(&o, sink, buf, sizeof(buf));",
+            f"    _{f.name}(&o{call});",
+            "    _gen_flush(&o);",
+            "    return (int) o.ctx.idx;",
+            "}",
+            "",
+            f"int {f.name}_snprintf(char *buffer, size_t count{f.params()}) {{",
+            "    struct _gen_out o;",
+            "    _gen_init(&o, NULL, buffer, buffer && count ? count : 0U);",
+            f"    _{f.name}(&o{call});",
+            "    if (buffer && count)",
+            "        buffer[o.len < count ? o.len : count-1] = '\\0'; // nul-terminate",
+            "    return (int) o.ctx.idx;",
+            "}",
+        ]
+
+    os.makedirs(outdir, exist_ok=True)
+    for fname, lines in ((f"{name}.h", h), (f"{name}.c", c)):
+        with open(os.path.join(outdir, fname), "w", encoding="utf-8") as out:
+            out.write("\n".join(lines) + "\n")
+
+
+def main() -> int:
+    if len(sys.argv) != 3:
+        print(f"Usage: {sys.argv[0]} MANIFEST OUTDIR", file=sys.stderr)
+        return 2
+    try:
+        generate(sys.argv[1], sys.argv[2])
+    except ManifestError as e:
+        print(f"{sys.argv[0]}: error: {e}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -32,3 +32,37 @@ endfunction()
 function(pico_wrap_function TARGET FUNCNAME)
     target_link_options(${TARGET} INTERFACE "LINKER:--wrap=${FUNCNAME}")
 endfunction()
+
+################################################################################
+# pico_fmt additions
+################################################################################
+
+set(PICO_FMT_CODEGEN "${CMAKE_CURRENT_LIST_DIR}/pico_fmt_codegen.py" CACHE INTERNAL "")
+set(PICO_FMT_SOURCE_DIR "${CMAKE_CURRENT_LIST_DIR}/../pico_fmt" CACHE INTERNAL "")
+
+# generate a specialized formatting function for each format in MANIFEST (see pico_fmt_codegen.py for the
+# syntax), and add them to TARGET, which must link pico_fmt; they are declared in a header named after MANIFEST
+# (e.g. "log_formats.h" for log_formats.fmt)
+function(pico_fmt_generate TARGET MANIFEST)
+    find_package(Python3 REQUIRED COMPONENTS Interpreter)
+    get_filename_component(MANIFEST "${MANIFEST}" ABSOLUTE)
+    get_filename_component(NAME "${MANIFEST}" NAME_WE)
+    set(OUTDIR "${CMAKE_CURRENT_BINARY_DIR}/${TARGET}_fmt")
+    add_custom_command(
+        OUTPUT "${OUTDIR}/${NAME}.c" "${OUTDIR}/${NAME}.h"
+        COMMAND Python3::Interpreter "${PICO_FMT_CODEGEN}" "${MANIFEST}" "${OUTDIR}"
+        DEPENDS "${MANIFEST}" "${PICO_FMT_CODEGEN}"
+        COMMENT "Generating formatters from ${NAME}"
+        VERBATIM
+    )
+    # the generated code calls pico_fmt's internal conversions
+    set_source_files_properties("${OUTDIR}/${NAME}.c" PROPERTIES INCLUDE_DIRECTORIES "${PICO_FMT_SOURCE_DIR}")
+    get_target_property(target_type ${TARGET} TYPE)
+    if ("INTERFACE_LIBRARY" STREQUAL "${target_type}")
+        target_sources(${TARGET} INTERFACE "${OUTDIR}/${NAME}.c" "${OUTDIR}/${NAME}.h")
+        target_include_directories(${TARGET} INTERFACE "${OUTDIR}")
+    else()
+        target_sources(${TARGET} PRIVATE "${OUTDIR}/${NAME}.c" "${OUTDIR}/${NAME}.h")
+        target_include_directories(${TARGET} PRIVATE "${OUTDIR}")
+    endif()
+endfunction()
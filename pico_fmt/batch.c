@@ -0,0 +1,255 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stdint.h>
+
+#include "pico/fmt_batch.h"
+#include "printf_internal.h"
+
+// Compiling the format ////////////////////////////////////////////////////////
+//
+// The format is parsed once in to a list of ops, each of which is the
+// literal text leading up to a directive and the parsed directive; the
+// literal text after the last directive is kept separately.
+
+struct _batch_op {
+    const char          *lit;
+    size_t               lit_len;
+    struct fmt_state     state; // with the _FMT_FLAG_*_STAR bits moved to .star
+    uint8_t              conv;  // enum _fmt_conv
+    uint8_t              star;  // _FMT_FLAG_*_STAR >> 8
+    uint8_t              size;  // the size of the column type for integers, else 8
+    uint8_t              sign;  // whether the column type is signed
+    uint8_t              fast;  // enum _batch_fast
+};
+
+// Bare directives with a column no wider than an int skip struct
+// fmt_state entirely, the same as fmt_vctxprintf's fast paths.
+enum _batch_fast {
+    FAST_NONE,
+    FAST_SINT,
+    FAST_UINT,
+    FAST_HEX,
+    FAST_HEX_UPPER,
+    FAST_CHAR,
+    FAST_STR,
+};
+
+struct _batch {
+    struct _batch_op     ops[PICO_PRINTF_BATCH_MAX_DIRECTIVES];
+    size_t               n;
+    const char          *tail;
+    size_t               tail_len;
+};
+
+// \return whether cols[*c] exists and suits conv, advancing *c past it
+static bool _take_column(const struct fmt_column *cols, size_t ncols, size_t *c, enum _fmt_conv conv) {
+    return *c < ncols && _fmt_type_suits(cols[(*c)++].type, conv);
+}
+
+static bool _batch_compile(struct _batch *b, const char *format, const struct fmt_column *cols, size_t ncols) {
+    size_t c = 0;
+    b->n = 0;
+    for (;;) {
+        const char *lit = format;
+        while (*format && *format != '%') {
+            format++;
+        }
+        b->tail = lit;
+        b->tail_len = (size_t) (format - lit);
+        if (!*format) {
+            break;
+        }
+        format++;
+        if (b->n == PICO_PRINTF_BATCH_MAX_DIRECTIVES) {
+            return false;
+        }
+        struct _batch_op *op = &b->ops[b->n];
+        const int conv = _fmt_parse_directive(&format, &op->state);
+        if (conv < 0) {
+            // like printf, stop at a directive that the format ends in the middle of
+            break;
+        }
+        if (_fmt_is_installed(op->state.specifier)) {
+            return false;
+        }
+        op->lit = lit;
+        op->lit_len = b->tail_len;
+        op->conv = (uint8_t) conv;
+        op->star = (uint8_t) ((op->state.flags & (_FMT_FLAG_WIDTH_STAR | _FMT_FLAG_PREC_STAR)) >> 8U);
+        op->state.flags &= ~(_FMT_FLAG_WIDTH_STAR | _FMT_FLAG_PREC_STAR);
+        for (unsigned int i = 0; i < __builtin_popcount(op->star); i++) {
+            if (!_take_column(cols, ncols, &c, CONV_SINT)) {
+                return false;
+            }
+        }
+        op->size = 8U;
+        op->sign = false;
+        op->fast = FAST_NONE;
+        if (conv != CONV_PCT && conv != CONV_NONE) {
+            if (!_take_column(cols, ncols, &c, (enum _fmt_conv) conv)) {
+                return false;
+            }
+            const enum fmt_type type = cols[c-1].type;
+            if (_fmt_type_is_integer(type)) {
+                op->size = (uint8_t) _fmt_type_size[type];
+                op->sign = _fmt_type_is_signed(type);
+            }
+            if (PICO_PRINTF_OPTIMIZE_SPEED && !op->state.flags && !op->state.width && !op->star
+                && (!_fmt_type_is_integer(type) || _fmt_type_size[type] <= sizeof(unsigned int))) {
+                switch (op->state.specifier) {
+                    case 'd': case 'i': op->fast = FAST_SINT;      break;
+                    case 'u':           op->fast = FAST_UINT;      break;
+                    case 'x':           op->fast = FAST_HEX;       break;
+                    case 'X':           op->fast = FAST_HEX_UPPER; break;
+                    case 'c':           op->fast = FAST_CHAR;      break;
+                    case 's':           op->fast = FAST_STR;       break;
+                }
+            }
+        }
+        b->n++;
+    }
+    return c == ncols;
+}
+
+// Writing rows ////////////////////////////////////////////////////////////////
+
+static inline union _fmt_value _fetch(const struct fmt_column *col, size_t row) {
+    const void *p = (const char *) col->base + row * col->stride;
+    union _fmt_value v;
+    switch (col->type) {
+        case FMT_TYPE_INT:    v.i = *(const int *) p;                break;
+        case FMT_TYPE_UINT:   v.u = *(const unsigned int *) p;       break;
+        case FMT_TYPE_LONG:   v.i = *(const long *) p;               break;
+        case FMT_TYPE_ULONG:  v.u = *(const unsigned long *) p;      break;
+        case FMT_TYPE_LLONG:  v.i = *(const long long *) p;          break;
+        case FMT_TYPE_ULLONG: v.u = *(const unsigned long long *) p; break;
+        case FMT_TYPE_INT8:   v.i = *(const int8_t *) p;             break;
+        case FMT_TYPE_UINT8:  v.u = *(const uint8_t *) p;            break;
+        case FMT_TYPE_INT16:  v.i = *(const int16_t *) p;            break;
+        case FMT_TYPE_UINT16: v.u = *(const uint16_t *) p;           break;
+        case FMT_TYPE_INT32:  v.i = *(const int32_t *) p;            break;
+        case FMT_TYPE_UINT32: v.u = *(const uint32_t *) p;           break;
+        case FMT_TYPE_INT64:  v.i = *(const int64_t *) p;            break;
+        case FMT_TYPE_UINT64: v.u = *(const uint64_t *) p;           break;
+        case FMT_TYPE_SIZE:   v.u = *(const size_t *) p;             break;
+        case FMT_TYPE_CHAR:   v.i = *(const char *) p;               break;
+        case FMT_TYPE_FLOAT:  v.f = *(const float *) p;              break;
+        case FMT_TYPE_DOUBLE: v.f = *(const double *) p;             break;
+        case FMT_TYPE_STR:    v.s = *(const char *const *) p;        break;
+        case FMT_TYPE_PTR:    v.p = *(const void *const *) p;        break;
+        default:              __builtin_unreachable();
+    }
+    return v;
+}
+
+static inline void _out_lit(const char *lit, size_t len, struct _fmt_ctx *ctx) {
+    for (size_t i = 0; i < len; i++) {
+        out(lit[i], ctx);
+    }
+}
+
+static void _batch_run(const struct _batch *b, struct _fmt_ctx *ctx,
+                       const struct fmt_column *cols, size_t nrows) {
+    for (size_t row = 0; row < nrows; row++) {
+        const struct fmt_column *col = cols;
+        for (const struct _batch_op *op = b->ops; op < &b->ops[b->n]; op++) {
+            _out_lit(op->lit, op->lit_len, ctx);
+#if PICO_PRINTF_OPTIMIZE_SPEED
+            switch (op->fast) {
+                case FAST_NONE:
+                    break;
+                case FAST_SINT: {
+                    const long long value = (long long) _fmt_int_value(_fetch(col++, row).u, op->size, op->sign, true);
+                    _fast_dec(ctx, (unsigned int) (value < 0 ? 0 - value : value), value < 0);
+                    continue;
+                }
+                case FAST_UINT:
+                    _fast_dec(ctx, (unsigned int) _fmt_int_value(_fetch(col++, row).u, op->size, op->sign, false), false);
+                    continue;
+                case FAST_HEX:
+                case FAST_HEX_UPPER:
+                    _fast_hex(ctx, (unsigned int) _fmt_int_value(_fetch(col++, row).u, op->size, op->sign, false),
+                              op->fast == FAST_HEX_UPPER);
+                    continue;
+                case FAST_CHAR:
+                    out((char) _fetch(col++, row).i, ctx);
+                    continue;
+                case FAST_STR:
+                    for (const char *p = _fetch(col++, row).s; *p; p++) {
+                        out(*p, ctx);
+                    }
+                    continue;
+            }
+#endif
+            struct fmt_state state = op->state;
+            state.ctx = ctx;
+            if (op->star & (_FMT_FLAG_WIDTH_STAR >> 8U)) {
+                _fmt_set_width(&state, (int) _fetch(col++, row).i);
+            }
+            if (op->star & (_FMT_FLAG_PREC_STAR >> 8U)) {
+                _fmt_set_precision(&state, (int) _fetch(col++, row).i);
+            }
+            union _fmt_value v = {0};
+            switch (op->conv) {
+                case CONV_SINT:
+                case CONV_UINT:
+                    // as printf would if given the column's type
+                    v.u = _fmt_int_value(_fetch(col++, row).u, op->size, op->sign, op->conv == CONV_SINT);
+                    break;
+                case CONV_PCT:
+                case CONV_NONE:
+                    break;
+                default:
+                    v = _fetch(col++, row);
+                    break;
+            }
+            _fmt_convert(&state, op->conv, v);
+        }
+        _out_lit(b->tail, b->tail_len, ctx);
+    }
+}
+
+// Outputs /////////////////////////////////////////////////////////////////////
+
+int fmt_batch_fct(fmt_fct_t fct, void *arg, const char *format,
+                  const struct fmt_column *cols, size_t ncols, size_t nrows) {
+    struct _batch b;
+    if (!_batch_compile(&b, format, cols, ncols)) {
+        return -1;
+    }
+    struct _fmt_ctx ctx = {
+        .fct = fct,
+        .arg = arg,
+        .idx = 0,
+    };
+    _batch_run(&b, &ctx, cols, nrows);
+    return (int) ctx.idx;
+}
+
+int fmt_batch_snprintf(char *buffer, size_t count, const char *format,
+                       const struct fmt_column *cols, size_t ncols, size_t nrows) {
+    _arg_buffer arg = {
+        .buffer = buffer,
+        .maxlen = count,
+        .cur = 0,
+    };
+    const int ret = fmt_batch_fct(buffer && count ? _out_buffer : NULL, &arg, format, cols, ncols, nrows);
+    if (buffer && count)
+        buffer[arg.cur < count ? arg.cur : count-1] = '\0'; // nul-terminate
+    return ret;
+}
+
+int fmt_batch_sink(struct fmt_sink *sink, const char *format,
+                   const struct fmt_column *cols, size_t ncols, size_t nrows) {
+    char buf[PICO_PRINTF_SINK_BUFFER_SIZE];
+    struct _fmt_sink_stage stage = {
+        .sink = sink,
+        .buf = buf,
+        .cap = sizeof(buf),
+        .len = 0,
+    };
+    const int ret = fmt_batch_fct(_fmt_out_stage, &stage, format, cols, ncols, nrows);
+    fmt_sink_write(sink, stage.buf, stage.len);
+    return ret;
+}
@@ -0,0 +1,178 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <errno.h>     /* for errno, EINTR, EINVAL, ENOMEM */
+#include <limits.h>    /* for IOV_MAX */
+#include <pthread.h>   /* for pthread_create(), pthread_join() */
+#include <stdlib.h>    /* for malloc(), calloc(), free() */
+#include <sys/uio.h>   /* for writev() */
+#include <unistd.h>    /* for sysconf() */
+
+#include "pico/fmt_batch_parallel.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// Each worker formats its rows in to a chain of fixed-size blocks,
+// each of which becomes one iovec; so the output is neither formatted
+// twice (to measure it first) nor copied (to grow a buffer).
+struct _block {
+    struct _block       *next;
+    size_t               len;
+    char                 data[PICO_PRINTF_PARALLEL_BLOCK_SIZE];
+};
+
+struct _worker {
+    pthread_t            thread;
+    bool                 started;
+    const char          *format;
+    struct fmt_column   *cols; // shifted to the worker's first row
+    size_t               ncols;
+    size_t               nrows;
+    struct _block       *head;
+    struct _block       *tail;
+    size_t               nblocks;
+    int                  err;
+};
+
+static void _out_block(char character, void *_w) {
+    struct _worker *w = _w;
+    if (w->tail->len == sizeof(w->tail->data)) {
+        struct _block *b = malloc(sizeof(*b));
+        if (!b) {
+            w->err = ENOMEM;
+            return;
+        }
+        b->next = NULL;
+        b->len = 0;
+        w->tail->next = b;
+        w->tail = b;
+        w->nblocks++;
+    }
+    w->tail->data[w->tail->len++] = character;
+}
+
+static void *_work(void *_w) {
+    struct _worker *w = _w;
+    w->head = w->tail = malloc(sizeof(*w->head));
+    if (!w->head) {
+        w->err = ENOMEM;
+        return NULL;
+    }
+    w->head->next = NULL;
+    w->head->len = 0;
+    w->nblocks = 1;
+    fmt_batch_fct(_out_block, w, w->format, w->cols, w->ncols, w->nrows);
+    return NULL;
+}
+
+static ssize_t _writev_all(int fd, struct iovec *iov, size_t iovcnt) {
+    ssize_t total = 0;
+    while (iovcnt) {
+        const ssize_t n = writev(fd, iov, (int) (iovcnt < IOV_MAX ? iovcnt : IOV_MAX));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        total += n;
+        // skip past what got written, which may end part way through an iovec
+        size_t rest = (size_t) n;
+        while (iovcnt && rest >= iov->iov_len) {
+            rest -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt) {
+            iov->iov_base = (char *) iov->iov_base + rest;
+            iov->iov_len -= rest;
+        }
+    }
+    return total;
+}
+
+ssize_t fmt_batch_writev(int fd, unsigned int nthreads, const char *format,
+                         const struct fmt_column *cols, size_t ncols, size_t nrows) {
+    if (fmt_batch_fct(NULL, NULL, format, cols, ncols, 0) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!nthreads) {
+        const long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = ncpus > 0 ? (unsigned int) ncpus : 1U;
+    }
+    if (nthreads > nrows) {
+        nthreads = nrows ? (unsigned int) nrows : 1U;
+    }
+
+    struct _worker *workers = calloc(nthreads, sizeof(*workers));
+    struct fmt_column *shifted = calloc(nthreads * ncols + 1, sizeof(*shifted)); // +1 so ncols=0 isn't NULL
+    if (!workers || !shifted) {
+        free(workers);
+        free(shifted);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    // hand out the rows as evenly as possible, in order
+    size_t row = 0;
+    for (unsigned int i = 0; i < nthreads; i++) {
+        struct _worker *w = &workers[i];
+        w->format = format;
+        w->cols = &shifted[i * ncols];
+        w->ncols = ncols;
+        w->nrows = nrows / nthreads + (i < nrows % nthreads);
+        for (size_t c = 0; c < ncols; c++) {
+            w->cols[c] = cols[c];
+            w->cols[c].base = (const char *) cols[c].base + row * cols[c].stride;
+        }
+        row += w->nrows;
+    }
+
+    // if a thread can't be started, its range is done on this thread instead
+    for (unsigned int i = 1; i < nthreads; i++) {
+        workers[i].started = !pthread_create(&workers[i].thread, NULL, _work, &workers[i]);
+    }
+    _work(&workers[0]);
+    int err = 0;
+    size_t nblocks = 0;
+    for (unsigned int i = 0; i < nthreads; i++) {
+        if (workers[i].started) {
+            pthread_join(workers[i].thread, NULL);
+        } else if (i) {
+            _work(&workers[i]);
+        }
+        if (workers[i].err) {
+            err = workers[i].err;
+        }
+        nblocks += workers[i].nblocks;
+    }
+
+    struct iovec *iov = err ? NULL : calloc(nblocks, sizeof(*iov));
+    ssize_t ret;
+    if (!iov) {
+        errno = err ? err : ENOMEM;
+        ret = -1;
+    } else {
+        size_t n = 0;
+        for (unsigned int i = 0; i < nthreads; i++) {
+            for (struct _block *b = workers[i].head; b; b = b->next) {
+                iov[n++] = (struct iovec){ .iov_base = b->data, .iov_len = b->len };
+            }
+        }
+        ret = _writev_all(fd, iov, n);
+    }
+
+    for (unsigned int i = 0; i < nthreads; i++) {
+        for (struct _block *b = workers[i].head, *next; b; b = next) {
+            next = b->next;
+            free(b);
+        }
+    }
+    free(workers);
+    free(shifted);
+    free(iov);
+    return ret;
+}
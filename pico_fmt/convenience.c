@@ -7,44 +7,68 @@
 // Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
 // SPDX-License-Identifier: BSD-3-Clause
 
-#include "pico/fmt_printf.h"
+#include "printf_internal.h"
 
-// Outputs /////////////////////////////////////////////////////////////////////
+// va_list wrappers ////////////////////////////////////////////////////////////
 
-typedef struct {
-    char        *buffer;
-    size_t       maxlen;
-    size_t       cur;
-} _arg_buffer;
+#if !PICO_PRINTF_BUFFER_SINK
+PICO_FMT_API int fmt_vsnprintf(char *buffer, size_t count, const char *format, va_list va) {
+    _arg_buffer arg = {
+        .buffer = buffer,
+        .maxlen = count,
+        .cur = 0,
+    };
+    const int ret = fmt_vfctprintf(buffer && count ? _out_buffer : NULL, &arg, format, va);
+    if (buffer && count)
+        buffer[arg.cur < count ? arg.cur : count-1] = '\0'; // nul-terminate
+    return ret;
+}
+#endif
 
-static void _out_buffer(char character, void *_arg) {
-    _arg_buffer *arg = _arg;
-    if (arg->cur < arg->maxlen) {
-        arg->buffer[arg->cur++] = character;
-    }
+PICO_FMT_API int fmt_snprintf_args(char *buffer, size_t count, const char *format, const struct fmt_arg *args, size_t n) {
+    _arg_buffer arg = {
+        .buffer = buffer,
+        .maxlen = count,
+        .cur = 0,
+    };
+    const int ret = fmt_fctprintf_args(buffer && count ? _out_buffer : NULL, &arg, format, args, n);
+    if (buffer && count)
+        buffer[arg.cur < count ? arg.cur : count-1] = '\0'; // nul-terminate
+    return ret;
 }
 
-// va_list wrappers ////////////////////////////////////////////////////////////
+PICO_FMT_API int fmt_snprintf_spec(char *buffer, size_t count, const struct fmt_spec *specs, size_t n, const struct fmt_arg *args) {
+    _arg_buffer arg = {
+        .buffer = buffer,
+        .maxlen = count,
+        .cur = 0,
+    };
+    const int ret = fmt_fctprintf_spec(buffer && count ? _out_buffer : NULL, &arg, specs, n, args);
+    if (buffer && count)
+        buffer[arg.cur < count ? arg.cur : count-1] = '\0'; // nul-terminate
+    return ret;
+}
 
-int fmt_vsnprintf(char *buffer, size_t count, const char *format, va_list va) {
+PICO_FMT_API int fmt_vsnprintf_limited(const struct fmt_limits *limits, char *buffer, size_t count,
+                                       const char *format, va_list va) {
     _arg_buffer arg = {
         .buffer = buffer,
         .maxlen = count,
         .cur = 0,
     };
-    const int ret = fmt_vfctprintf(buffer && count ? _out_buffer : NULL, &arg, format, va);
+    const int ret = fmt_vfctprintf_limited(limits, buffer && count ? _out_buffer : NULL, &arg, format, va);
     if (buffer && count)
         buffer[arg.cur < count ? arg.cur : count-1] = '\0'; // nul-terminate
     return ret;
 }
 
-int fmt_vsprintf(char *buffer, const char *format, va_list va) {
+PICO_FMT_API int fmt_vsprintf(char *buffer, const char *format, va_list va) {
     return fmt_vsnprintf(buffer, (size_t) -1, format, va);
 }
 
 // Var-args wrappers ///////////////////////////////////////////////////////////
 
-int fmt_fctprintf(fmt_fct_t out, void *arg, const char *format, ...) {
+PICO_FMT_API int fmt_fctprintf(fmt_fct_t out, void *arg, const char *format, ...) {
     va_list va;
     va_start(va, format);
     const int ret = fmt_vfctprintf(out, arg, format, va);
@@ -52,7 +76,24 @@ int fmt_fctprintf(fmt_fct_t out, void *arg, const char *format, ...) {
     return ret;
 }
 
-int fmt_snprintf(char *buffer, size_t count, const char *format, ...) {
+PICO_FMT_API int fmt_ctxprintf(const struct fmt_locale *locale, fmt_fct_t out, void *arg, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_vctxprintf(locale, out, arg, format, va);
+    va_end(va);
+    return ret;
+}
+
+PICO_FMT_API int fmt_fctprintf_limited(const struct fmt_limits *limits, fmt_fct_t out, void *arg,
+                                       const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_vfctprintf_limited(limits, out, arg, format, va);
+    va_end(va);
+    return ret;
+}
+
+PICO_FMT_API int fmt_snprintf(char *buffer, size_t count, const char *format, ...) {
     va_list va;
     va_start(va, format);
     const int ret = fmt_vsnprintf(buffer, count, format, va);
@@ -60,7 +101,16 @@ int fmt_snprintf(char *buffer, size_t count, const char *format, ...) {
     return ret;
 }
 
-int fmt_sprintf(char *buffer, const char *format, ...) {
+PICO_FMT_API int fmt_snprintf_limited(const struct fmt_limits *limits, char *buffer, size_t count,
+                                      const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_vsnprintf_limited(limits, buffer, count, format, va);
+    va_end(va);
+    return ret;
+}
+
+PICO_FMT_API int fmt_sprintf(char *buffer, const char *format, ...) {
     va_list va;
     va_start(va, format);
     const int ret = fmt_vsprintf(buffer, format, va);
@@ -0,0 +1,275 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stdint.h>
+
+#include "pico/fmt_format.h"
+#include "printf_internal.h"
+
+// Arguments ///////////////////////////////////////////////////////////////////
+
+// *next once a field has given an arg_id; fields must either all give
+// one or all not.
+#define _MANUAL SIZE_MAX
+
+// Take the argument for a field (or a nested width or precision),
+// which starts with an optional arg_id at *formatp.
+//
+// \return the argument, or NULL if there isn't one
+static const struct fmt_arg *_take_arg(const char **formatp, const struct fmt_arg *args, size_t n, size_t *next) {
+    const char *format = *formatp;
+    size_t idx = 0U;
+    if (*format >= '0' && *format <= '9') {
+        if (*next && *next != _MANUAL) {
+            return NULL;
+        }
+        *next = _MANUAL;
+        for (; *format >= '0' && *format <= '9'; format++) {
+            idx = idx * 10U + (size_t) (*format - '0');
+            if (idx > n) {
+                idx = n; // don't overflow
+            }
+        }
+    } else {
+        if (*next == _MANUAL) {
+            return NULL;
+        }
+        idx = (*next)++;
+    }
+    *formatp = format;
+    return idx < n ? &args[idx] : NULL;
+}
+
+// A nested "{}" or "{arg_id}" width or precision, at *formatp.
+static bool _nested(const char **formatp, const struct fmt_arg *args, size_t n, size_t *next, unsigned int *value) {
+    (*formatp)++;
+    const struct fmt_arg *a = _take_arg(formatp, args, n, next);
+    if (!a || **formatp != '}' || !_fmt_type_is_integer(a->type)
+        || (_fmt_type_is_signed(a->type) && a->i < 0)) {
+        return false;
+    }
+    (*formatp)++;
+    *value = (unsigned int) a->u;
+    return true;
+}
+
+// Replacement fields //////////////////////////////////////////////////////////
+
+static inline bool _is_align(char c) {
+    return c == '<' || c == '>' || c == '^';
+}
+
+// Pick the conversion (and the printf specifier to give it) that
+// presents an argument of `atype` as `type` ('\0' for the default).
+//
+// \return the conversion, or CONV_NONE if `type` doesn't suit `atype`
+static enum _fmt_conv _presentation(enum fmt_type atype, char type, char *specifier) {
+    if (_fmt_type_is_integer(atype)) {
+        const bool sign = _fmt_type_is_signed(atype);
+        if (!type) {
+            type = atype == FMT_TYPE_CHAR ? 'c' : 'd';
+        }
+        switch (type) {
+            case 'c':
+                *specifier = 'c';
+                return CONV_CHAR;
+            case 'd':
+                *specifier = sign ? 'd' : 'u';
+                return sign ? CONV_SINT : CONV_UINT;
+            case 'b': case 'o': case 'x': case 'X':
+                // a signed negative value is printed as '-' and its magnitude
+                *specifier = type;
+                return sign ? CONV_SINT : CONV_UINT;
+        }
+        return CONV_NONE;
+    }
+    switch (atype) {
+        case FMT_TYPE_FLOAT:
+        case FMT_TYPE_DOUBLE:
+            switch (type) {
+                case '\0':
+                    *specifier = 'g';
+                    return CONV_DOUBLE;
+                case 'e': case 'E': case 'f': case 'F': case 'g': case 'G':
+                    *specifier = type;
+                    return CONV_DOUBLE;
+            }
+            return CONV_NONE;
+        case FMT_TYPE_STR:
+            *specifier = 's';
+            return !type || type == 's' ? CONV_STR : CONV_NONE;
+        case FMT_TYPE_PTR:
+            *specifier = 'p';
+            return !type || type == 'p' ? CONV_PTR : CONV_NONE;
+        default:
+            return CONV_NONE;
+    }
+}
+
+// Format the field starting just after the '{' at *formatp, leaving
+// *formatp just past its '}'.
+//
+// \return false if the field is malformed or has no suitable argument
+static bool _field(struct _fmt_ctx *ctx, const char **formatp, const struct fmt_arg *args, size_t n, size_t *next) {
+    const char *format = *formatp;
+    const struct fmt_arg *a = _take_arg(&format, args, n, next);
+    if (!a) {
+        return false;
+    }
+
+    struct fmt_state state = {
+        .flags     = 0U,
+        .width     = 0U,
+        .precision = 0U,
+        .size      = FMT_SIZE_DEFAULT,
+        .args      = NULL,
+        .ctx       = ctx,
+    };
+    char fill = ' ';
+    char align = '\0';
+    char type = '\0';
+    if (*format == ':') {
+        format++;
+        // [[fill]align][sign][#][0][width][.precision][type]
+        if (*format && *format != '{' && *format != '}' && _is_align(format[1])) {
+            fill = format[0];
+            align = format[1];
+            format += 2;
+        } else if (_is_align(*format)) {
+            align = *format++;
+        }
+        switch (*format) {
+            case '+': state.flags |= FMT_FLAG_PLUS;  format++; break;
+            case ' ': state.flags |= FMT_FLAG_SPACE; format++; break;
+            case '-':                                format++; break;
+        }
+        if (*format == '#') {
+            state.flags |= FMT_FLAG_HASH;
+            format++;
+        }
+        if (*format == '0') {
+            if (!align) {
+                state.flags |= FMT_FLAG_ZEROPAD;
+            }
+            format++;
+        }
+        if (*format == '{') {
+            if (!_nested(&format, args, n, next, &state.width)) {
+                return false;
+            }
+        } else {
+            for (; *format >= '0' && *format <= '9'; format++) {
+                state.width = state.width * 10U + (unsigned int) (*format - '0');
+            }
+        }
+        if (*format == '.') {
+            state.flags |= FMT_FLAG_PRECISION;
+            format++;
+            if (*format == '{') {
+                if (!_nested(&format, args, n, next, &state.precision)) {
+                    return false;
+                }
+            } else if (*format >= '0' && *format <= '9') {
+                for (; *format >= '0' && *format <= '9'; format++) {
+                    state.precision = state.precision * 10U + (unsigned int) (*format - '0');
+                }
+            } else {
+                return false;
+            }
+        }
+        if (*format && *format != '}') {
+            type = *format++;
+        }
+    }
+    if (*format != '}') {
+        return false;
+    }
+    *formatp = format + 1;
+
+    const enum _fmt_conv conv = _presentation(a->type, type, &state.specifier);
+    if (conv == CONV_NONE) {
+        return false;
+    }
+    if ((state.flags & FMT_FLAG_PRECISION) && conv != CONV_DOUBLE && conv != CONV_STR) {
+        return false;
+    }
+
+    if (align == '^' || (align && fill != ' ')) {
+        // The conversions only know how to pad with spaces on one side;
+        // so find out how long the output is, and pad it ourselves.
+        const unsigned int width = state.width;
+        state.width = 0U;
+        struct _fmt_ctx measure = {
+            .fct = NULL,
+            .idx = 0,
+        };
+        struct fmt_state probe = state;
+        probe.ctx = &measure;
+        _fmt_convert_arg(&probe, conv, a);
+        const size_t pad = measure.idx < width ? width - measure.idx : 0U;
+        const size_t before = align == '<' ? 0U : align == '^' ? pad / 2U : pad;
+        _out_fill(ctx, fill, before);
+        _fmt_convert_arg(&state, conv, a);
+        _out_fill(ctx, fill, pad - before);
+        return true;
+    }
+
+    // as std::format: strings and chars default to the left, numbers to the right
+    if (align == '<' || (!align && (conv == CONV_STR || conv == CONV_CHAR))) {
+        state.flags |= FMT_FLAG_LEFT;
+    }
+    _fmt_convert_arg(&state, conv, a);
+    return true;
+}
+
+// Outputs /////////////////////////////////////////////////////////////////////
+
+int fmt_fctformat_args(fmt_fct_t fct, void *arg, const char *format, const struct fmt_arg *args, size_t n) {
+    struct _fmt_ctx ctx = {
+        .fct = fct,
+        .arg = arg,
+        .idx = 0,
+    };
+    size_t next = 0U;
+
+    while (*format) {
+        const char c = *format++;
+        if (c == '{' || c == '}') {
+            if (*format != c) {
+                if (c == '}' || !_field(&ctx, &format, args, n, &next)) {
+                    return -1;
+                }
+                continue;
+            }
+            format++; // "{{" or "}}"
+        }
+        out(c, &ctx);
+    }
+
+    return (int) ctx.idx;
+}
+
+int fmt_snformat_args(char *buffer, size_t count, const char *format, const struct fmt_arg *args, size_t n) {
+    _arg_buffer arg = {
+        .buffer = buffer,
+        .maxlen = count,
+        .cur = 0,
+    };
+    const int ret = fmt_fctformat_args(buffer && count ? _out_buffer : NULL, &arg, format, args, n);
+    if (buffer && count)
+        buffer[arg.cur < count ? arg.cur : count-1] = '\0'; // nul-terminate
+    return ret;
+}
+
+int fmt_sinkformat_args(struct fmt_sink *sink, const char *format, const struct fmt_arg *args, size_t n) {
+    char buf[PICO_PRINTF_SINK_BUFFER_SIZE];
+    struct _fmt_sink_stage stage = {
+        .sink = sink,
+        .buf = buf,
+        .cap = sizeof(buf),
+        .len = 0,
+    };
+    const int ret = fmt_fctformat_args(_fmt_out_stage, &stage, format, args, n);
+    fmt_sink_write(sink, stage.buf, stage.len);
+    return ret;
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_BATCH_H
+#define _PICO_FMT_BATCH_H
+
+#include <stddef.h>  /* for size_t */
+
+#include "pico/fmt_printf.h"
+#include "pico/fmt_sink.h"
+
+/** \file fmt_batch.h
+ *  \defgroup pico_fmt_batch pico_fmt_batch
+ *
+ * \brief Apply one format to many rows of arguments
+ *
+ * Rather than a va_list, the arguments come from an array of columns,
+ * each of which says what C type its values are and where to find the
+ * value for each row.  The same descriptors work for an array of
+ * structs (row-major) and for a struct of arrays (columnar):
+ *
+ * ```c
+ * struct sample { uint32_t ts; int16_t temp; const char *name; } rows[N];
+ * const struct fmt_column cols[] = {
+ *     FMT_FIELD(FMT_TYPE_UINT32, rows, ts),
+ *     FMT_FIELD(FMT_TYPE_INT16,  rows, temp),
+ *     FMT_FIELD(FMT_TYPE_STR,    rows, name),
+ * };
+ * fmt_batch_sink(sink, "%u,%d,%s\n", cols, 3, N);
+ *
+ * uint32_t ts[N]; float volts[N];
+ * const struct fmt_column cols2[] = {
+ *     FMT_COLUMN(FMT_TYPE_UINT32, ts),
+ *     FMT_COLUMN(FMT_TYPE_FLOAT,  volts),
+ * };
+ * fmt_batch_sink(sink, "%u,%.3f\n", cols2, 2, N);
+ * ```
+ *
+ * The format is parsed once, up front, and then each row is written
+ * without parsing it again.  Directives consume columns in order, the
+ * same as they would consume arguments: a "*" width or precision
+ * takes a column of its own, and "%%" takes none.
+ *
+ * Because each column says its own type, length modifiers in the
+ * format ("l", "ll", "z", ...) are accepted but ignored.  Integer
+ * values are otherwise converted the same way printf would if passed
+ * the column's type; e.g. "%x" of an FMT_TYPE_INT8 -1 is "ff".
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_BATCH_MAX_DIRECTIVES, Define the maximum number of directives in a format passed to the fmt_batch functions; each costs some on-stack space, min=1, default=16, group=pico_printf
+#ifndef PICO_PRINTF_BATCH_MAX_DIRECTIVES
+#define PICO_PRINTF_BATCH_MAX_DIRECTIVES 16U
+#endif
+
+struct fmt_column {
+    enum fmt_type        type;
+    const void          *base;   // the value for row 0
+    size_t               stride; // bytes from one row's value to the next
+};
+
+/**
+ * \brief A column that is an array of values, `array[row]`
+ */
+#define FMT_COLUMN(type, array) \
+    ((struct fmt_column){ (type), &(array)[0], sizeof((array)[0]) })
+
+/**
+ * \brief A column that is a member of an array of structs, `rows[row].field`
+ */
+#define FMT_FIELD(type, rows, field) \
+    ((struct fmt_column){ (type), &(rows)[0].field, sizeof((rows)[0]) })
+
+/**
+ * \brief Format `nrows` rows with an output function
+ *
+ * The format must not use any specifier that has been fmt_install()ed,
+ * must have at most PICO_PRINTF_BATCH_MAX_DIRECTIVES directives, and
+ * must consume exactly `ncols` columns, each of a type that suits its
+ * directive.  If any of that isn't so, then nothing is written.
+ *
+ * \return The total number of characters that are sent to the output
+ * function, not counting the terminating null character; or -1 if the
+ * format and the columns don't agree
+ */
+int fmt_batch_fct(fmt_fct_t out, void *arg, const char *format,
+                  const struct fmt_column *cols, size_t ncols, size_t nrows);
+
+/**
+ * \brief Like fmt_batch_fct(), but writes all of the rows in to one
+ * buffer, like snprintf
+ */
+int fmt_batch_snprintf(char *buffer, size_t count, const char *format,
+                       const struct fmt_column *cols, size_t ncols, size_t nrows);
+
+/**
+ * \brief Like fmt_batch_fct(), but writes to a sink, staged through a
+ * PICO_PRINTF_SINK_BUFFER_SIZE-byte buffer like fmt_vsinkprintf().
+ * This does not fmt_sink_flush() the sink.
+ */
+int fmt_batch_sink(struct fmt_sink *sink, const char *format,
+                   const struct fmt_column *cols, size_t ncols, size_t nrows);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _PICO_FMT_BATCH_H
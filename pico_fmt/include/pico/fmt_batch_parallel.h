@@ -0,0 +1,56 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_BATCH_PARALLEL_H
+#define _PICO_FMT_BATCH_PARALLEL_H
+
+#include <stddef.h>    /* for size_t */
+#include <sys/types.h> /* for ssize_t */
+
+#include "pico/fmt_batch.h"
+
+/** \file fmt_batch_parallel.h
+ *  \defgroup pico_fmt_parallel pico_fmt_parallel
+ *
+ * \brief Format a large batch across a pool of threads (Linux only)
+ *
+ * This is for formatting large captured data sets on a host, not for
+ * the microcontroller; it uses pthreads, malloc() and writev(), and is
+ * only built (as the pico_fmt_parallel library) on Linux.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_PARALLEL_BLOCK_SIZE, Define the size of the blocks that fmt_batch_writev's threads format in to, min=1, default=65536, group=pico_printf
+#ifndef PICO_PRINTF_PARALLEL_BLOCK_SIZE
+#define PICO_PRINTF_PARALLEL_BLOCK_SIZE 65536U
+#endif
+
+/**
+ * \brief Like fmt_batch_fct(), but split the rows across `nthreads`
+ * threads and write the result to the file descriptor `fd`
+ *
+ * Each thread takes a contiguous range of rows and formats it in to a
+ * chain of PICO_PRINTF_PARALLEL_BLOCK_SIZE-byte blocks.  The blocks
+ * are then written out in row order with writev(), without being
+ * copied together first.  The calling thread does the first range
+ * itself, so `nthreads` of 1 doesn't create any threads; 0 means one
+ * thread per online CPU.
+ *
+ * All of the output is held in memory until it is written.
+ *
+ * \return The number of bytes written, or -1 with errno set (EINVAL if
+ * the format and the columns don't agree, or whatever malloc() or
+ * writev() failed with); if writev() fails part way through then some
+ * of the output may have been written.
+ */
+ssize_t fmt_batch_writev(int fd, unsigned int nthreads, const char *format,
+                         const struct fmt_column *cols, size_t ncols, size_t nrows);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _PICO_FMT_BATCH_PARALLEL_H
@@ -0,0 +1,85 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_FORMAT_H
+#define _PICO_FMT_FORMAT_H
+
+#include <stddef.h>  /* for size_t */
+
+#include "pico/fmt_printf.h"
+#include "pico/fmt_sink.h"
+
+/** \file fmt_format.h
+ *  \defgroup pico_fmt_format pico_fmt_format
+ *
+ * \brief `{}`-style (C++20 std::format / Python str.format) formats
+ *
+ * ```c
+ * const struct fmt_arg args[] = { FMT_ARG_STR("pump"), FMT_ARG_DOUBLE(3.14159) };
+ * fmt_snformat_args(buf, sizeof(buf), "{:<6}|{:>8.3f}", args, 2); // "pump  |   3.142"
+ * ```
+ *
+ * Each replacement field is parsed in to the same struct fmt_state as
+ * a printf directive and run through the same conversions, so that a
+ * field gives the same output as the printf directive it corresponds
+ * to (e.g. "{:+08.3f}" as "%+08.3f", "{:#x}" as "%#x").  The
+ * arguments come from a struct fmt_arg array, since a field without a
+ * type ("{}") takes its presentation from its argument's type.
+ *
+ * The syntax is
+ *
+ *     {[arg_id][:[[fill]align][sign][#][0][width][.precision][type]]}
+ *
+ * with "{{" and "}}" for literal braces, where
+ *
+ *  - arg_id is an index in to the arguments; either every field has
+ *    one, or none does and they take the arguments in order;
+ *  - align is '<', '>' or '^', and fill (which defaults to ' ') is any
+ *    character other than '{' or '}';
+ *  - sign is '+', '-' or ' ';
+ *  - width and precision are either digits or a nested "{}"/"{arg_id}"
+ *    taking them from an integer argument;
+ *  - type is one of "bcdoxX" for integers (with "b", "o", "x" and "X"
+ *    of a negative signed integer giving a '-' and the magnitude),
+ *    "eEfFgG" for floating point, "s" for strings, and "p" for
+ *    pointers.
+ *
+ * Without a type, integers are as "d" (chars as "c"), floating point
+ * as "g", strings as "s" and pointers as "p".  As with std::format,
+ * strings and chars are left-aligned by default, and everything else
+ * right-aligned.  Unlike std::format, "{}" of a double is "%g" rather
+ * than the shortest representation that round-trips, and "p" is
+ * pico_fmt's "%p".
+ *
+ * A malformed format, or an argument that is missing or doesn't suit
+ * its field, makes these return -1 (though the output up to that point
+ * has already been written).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Format with an output function
+ *
+ * \return The number of characters that are sent to the output
+ * function, not counting the terminating null character; or -1 on error
+ */
+int fmt_fctformat_args(fmt_fct_t out, void *arg, const char *format, const struct fmt_arg *args, size_t n);
+
+/**
+ * \brief Format in to a buffer of `count` bytes, like snprintf
+ */
+int fmt_snformat_args(char *buffer, size_t count, const char *format, const struct fmt_arg *args, size_t n);
+
+/**
+ * \brief Format to a sink; see fmt_sinkprintf()
+ */
+int fmt_sinkformat_args(struct fmt_sink *sink, const char *format, const struct fmt_arg *args, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _PICO_FMT_FORMAT_H
@@ -0,0 +1,195 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_GENERIC_H
+#define _PICO_FMT_GENERIC_H
+
+#include <stddef.h>  /* for NULL */
+
+#include "pico/fmt_format.h"
+#include "pico/fmt_printf.h"
+#include "pico/fmt_sink.h"
+
+/** \file fmt_generic.h
+ *  \defgroup pico_fmt_generic pico_fmt_generic
+ *
+ * \brief Type-checked printf macros for C11, without a va_list
+ *
+ * ```c
+ * FMT(sink, "temp=%d ok=%s", t, s);
+ * FMT_SNPRINTF(buf, sizeof(buf), "%u", n);
+ * ```
+ *
+ * Each argument is tagged with its type by `_Generic` and put in a
+ * struct fmt_arg array at the call site, which is then passed to the
+ * non-variadic fmt_*_args() functions.  So an argument that doesn't
+ * suit its directive (e.g. a string for "%d") can't be misread: the
+ * call returns -1 instead.  A `long` for "%d" is fine, though; an
+ * argument's own type takes the place of the length modifier.
+ *
+ * Up to 16 arguments may be given.  Anything that isn't an arithmetic
+ * type or a string is passed as FMT_TYPE_PTR; `long double` and
+ * structs are compile errors.
+ *
+ * With GCC or Clang, the format is also checked against the arguments
+ * at compile time with -Wformat, as for printf.  That check doesn't
+ * know about fmt_install()ed specifiers (or about passing a `long` for
+ * "%d"); define PICO_PRINTF_GENERIC_CHECK_FORMAT to 0 to turn it off.
+ *
+ * FMT_FORMAT() and FMT_SNFORMAT() do the same for `{}`-style formats
+ * (see fmt_format.h), which -Wformat can't check.
+ *
+ * This header is C only (`_Generic` isn't C++).
+ */
+
+#ifdef __cplusplus
+#error "pico/fmt_generic.h requires C11 _Generic, which C++ doesn't have"
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_GENERIC_CHECK_FORMAT, Check the formats given to the FMT() macros at compile time with -Wformat (GCC and Clang only), type=bool, default=1, group=pico_printf
+#ifndef PICO_PRINTF_GENERIC_CHECK_FORMAT
+#define PICO_PRINTF_GENERIC_CHECK_FORMAT 1
+#endif
+
+/**
+ * \brief printf to a sink; see fmt_sinkprintf_args()
+ */
+#define FMT(sink, ...) \
+    (_FMT_CHECK(__VA_ARGS__) fmt_sinkprintf_args((sink), _FMT_ARGV(__VA_ARGS__)))
+
+/**
+ * \brief snprintf; see fmt_snprintf_args()
+ */
+#define FMT_SNPRINTF(buffer, count, ...) \
+    (_FMT_CHECK(__VA_ARGS__) fmt_snprintf_args((buffer), (count), _FMT_ARGV(__VA_ARGS__)))
+
+/**
+ * \brief printf with output function; see fmt_fctprintf_args()
+ */
+#define FMT_FCT(out, arg, ...) \
+    (_FMT_CHECK(__VA_ARGS__) fmt_fctprintf_args((out), (arg), _FMT_ARGV(__VA_ARGS__)))
+
+/**
+ * \brief `{}`-style format to a sink; see fmt_sinkformat_args()
+ */
+#define FMT_FORMAT(sink, ...) \
+    fmt_sinkformat_args((sink), _FMT_ARGV(__VA_ARGS__))
+
+/**
+ * \brief `{}`-style format in to a buffer; see fmt_snformat_args()
+ */
+#define FMT_SNFORMAT(buffer, count, ...) \
+    fmt_snformat_args((buffer), (count), _FMT_ARGV(__VA_ARGS__))
+
+/**
+ * \brief A struct fmt_arg for x, tagged with x's type
+ */
+#define FMT_ARG(x) _FMT_ARG_CTOR(x)(_FMT_ARG_TYPE(x), (x))
+
+// Implementation //////////////////////////////////////////////////////////////
+
+#define _FMT_ARG_TYPE(x) _Generic((x),         \
+    _Bool:              FMT_TYPE_INT,          \
+    char:               FMT_TYPE_CHAR,         \
+    signed char:        FMT_TYPE_INT8,         \
+    unsigned char:      FMT_TYPE_UINT8,        \
+    short:              FMT_TYPE_INT16,        \
+    unsigned short:     FMT_TYPE_UINT16,       \
+    int:                FMT_TYPE_INT,          \
+    unsigned int:       FMT_TYPE_UINT,         \
+    long:               FMT_TYPE_LONG,         \
+    unsigned long:      FMT_TYPE_ULONG,        \
+    long long:          FMT_TYPE_LLONG,        \
+    unsigned long long: FMT_TYPE_ULLONG,       \
+    float:              FMT_TYPE_FLOAT,        \
+    double:             FMT_TYPE_DOUBLE,       \
+    char *:             FMT_TYPE_STR,          \
+    const char *:       FMT_TYPE_STR,          \
+    default:            FMT_TYPE_PTR)
+
+#define _FMT_ARG_CTOR(x) _Generic((x),         \
+    _Bool:              _fmt_arg_i,            \
+    char:               _fmt_arg_i,            \
+    signed char:        _fmt_arg_i,            \
+    unsigned char:      _fmt_arg_u,            \
+    short:              _fmt_arg_i,            \
+    unsigned short:     _fmt_arg_u,            \
+    int:                _fmt_arg_i,            \
+    unsigned int:       _fmt_arg_u,            \
+    long:               _fmt_arg_i,            \
+    unsigned long:      _fmt_arg_u,            \
+    long long:          _fmt_arg_i,            \
+    unsigned long long: _fmt_arg_u,            \
+    float:              _fmt_arg_f,            \
+    double:             _fmt_arg_f,            \
+    char *:             _fmt_arg_s,            \
+    const char *:       _fmt_arg_s,            \
+    default:            _fmt_arg_p)
+
+static inline struct fmt_arg _fmt_arg_i(enum fmt_type type, long long v) {
+    return (struct fmt_arg){ .type = type, .i = v };
+}
+static inline struct fmt_arg _fmt_arg_u(enum fmt_type type, unsigned long long v) {
+    return (struct fmt_arg){ .type = type, .u = v };
+}
+static inline struct fmt_arg _fmt_arg_f(enum fmt_type type, double v) {
+    return (struct fmt_arg){ .type = type, .f = v };
+}
+static inline struct fmt_arg _fmt_arg_s(enum fmt_type type, const char *v) {
+    return (struct fmt_arg){ .type = type, .s = v };
+}
+static inline struct fmt_arg _fmt_arg_p(enum fmt_type type, const void *v) {
+    return (struct fmt_arg){ .type = type, .p = v };
+}
+
+// never defined; only "called" inside sizeof, for -Wformat
+#if PICO_PRINTF_GENERIC_CHECK_FORMAT && defined(__GNUC__)
+__attribute__((format(printf, 1, 2))) int _fmt_check_format(const char *format, ...);
+#define _FMT_CHECK(...) (void) sizeof(_fmt_check_format(__VA_ARGS__)),
+#else
+#define _FMT_CHECK(...)
+#endif
+
+// _FMT_ARGV(format, args...) -> format, (const struct fmt_arg[]){ ... }, n
+#define _FMT_CAT(a, b)  _FMT_CAT_(a, b)
+#define _FMT_CAT_(a, b) a##b
+#define _FMT_NARGS(...) _FMT_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, ~)
+#define _FMT_NARGS_(f, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n, ...) n
+#define _FMT_ARGV(...)  _FMT_CAT(_FMT_ARGV_, _FMT_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+#define _FMT_ARGV_0(f)       (f), NULL, 0
+#define _FMT_ARGV_1(f, ...)  (f), (const struct fmt_arg[]){ _FMT_MAP_1(__VA_ARGS__) }, 1
+#define _FMT_ARGV_2(f, ...)  (f), (const struct fmt_arg[]){ _FMT_MAP_2(__VA_ARGS__) }, 2
+#define _FMT_ARGV_3(f, ...)  (f), (const struct fmt_arg[]){ _FMT_MAP_3(__VA_ARGS__) }, 3
+#define _FMT_ARGV_4(f, ...)  (f), (const struct fmt_arg[]){ _FMT_MAP_4(__VA_ARGS__) }, 4
+#define _FMT_ARGV_5(f, ...)  (f), (const struct fmt_arg[]){ _FMT_MAP_5(__VA_ARGS__) }, 5
+#define _FMT_ARGV_6(f, ...)  (f), (const struct fmt_arg[]){ _FMT_MAP_6(__VA_ARGS__) }, 6
+#define _FMT_ARGV_7(f, ...)  (f), (const struct fmt_arg[]){ _FMT_MAP_7(__VA_ARGS__) }, 7
+#define _FMT_ARGV_8(f, ...)  (f), (const struct fmt_arg[]){ _FMT_MAP_8(__VA_ARGS__) }, 8
+#define _FMT_ARGV_9(f, ...)  (f), (const struct fmt_arg[]){ _FMT_MAP_9(__VA_ARGS__) }, 9
+#define _FMT_ARGV_10(f, ...) (f), (const struct fmt_arg[]){ _FMT_MAP_10(__VA_ARGS__) }, 10
+#define _FMT_ARGV_11(f, ...) (f), (const struct fmt_arg[]){ _FMT_MAP_11(__VA_ARGS__) }, 11
+#define _FMT_ARGV_12(f, ...) (f), (const struct fmt_arg[]){ _FMT_MAP_12(__VA_ARGS__) }, 12
+#define _FMT_ARGV_13(f, ...) (f), (const struct fmt_arg[]){ _FMT_MAP_13(__VA_ARGS__) }, 13
+#define _FMT_ARGV_14(f, ...) (f), (const struct fmt_arg[]){ _FMT_MAP_14(__VA_ARGS__) }, 14
+#define _FMT_ARGV_15(f, ...) (f), (const struct fmt_arg[]){ _FMT_MAP_15(__VA_ARGS__) }, 15
+#define _FMT_ARGV_16(f, ...) (f), (const struct fmt_arg[]){ _FMT_MAP_16(__VA_ARGS__) }, 16
+
+#define _FMT_MAP_1(x)       FMT_ARG(x)
+#define _FMT_MAP_2(x, ...)  FMT_ARG(x), _FMT_MAP_1(__VA_ARGS__)
+#define _FMT_MAP_3(x, ...)  FMT_ARG(x), _FMT_MAP_2(__VA_ARGS__)
+#define _FMT_MAP_4(x, ...)  FMT_ARG(x), _FMT_MAP_3(__VA_ARGS__)
+#define _FMT_MAP_5(x, ...)  FMT_ARG(x), _FMT_MAP_4(__VA_ARGS__)
+#define _FMT_MAP_6(x, ...)  FMT_ARG(x), _FMT_MAP_5(__VA_ARGS__)
+#define _FMT_MAP_7(x, ...)  FMT_ARG(x), _FMT_MAP_6(__VA_ARGS__)
+#define _FMT_MAP_8(x, ...)  FMT_ARG(x), _FMT_MAP_7(__VA_ARGS__)
+#define _FMT_MAP_9(x, ...)  FMT_ARG(x), _FMT_MAP_8(__VA_ARGS__)
+#define _FMT_MAP_10(x, ...) FMT_ARG(x), _FMT_MAP_9(__VA_ARGS__)
+#define _FMT_MAP_11(x, ...) FMT_ARG(x), _FMT_MAP_10(__VA_ARGS__)
+#define _FMT_MAP_12(x, ...) FMT_ARG(x), _FMT_MAP_11(__VA_ARGS__)
+#define _FMT_MAP_13(x, ...) FMT_ARG(x), _FMT_MAP_12(__VA_ARGS__)
+#define _FMT_MAP_14(x, ...) FMT_ARG(x), _FMT_MAP_13(__VA_ARGS__)
+#define _FMT_MAP_15(x, ...) FMT_ARG(x), _FMT_MAP_14(__VA_ARGS__)
+#define _FMT_MAP_16(x, ...) FMT_ARG(x), _FMT_MAP_15(__VA_ARGS__)
+
+#endif // _PICO_FMT_GENERIC_H
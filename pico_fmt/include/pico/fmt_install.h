@@ -8,11 +8,13 @@
 #define _PICO_FMT_INSTALL_H
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 #include "pico/fmt_printf.h"
 
 #ifdef __cplusplus
-//extern "C" {
+extern "C" {
 #endif
 
 // For implementing your custom specifier //////////////////////////////////////
@@ -49,19 +51,184 @@ struct fmt_state {
 
 /**
  * \brief The function signature that your custom handler must implement.
+ *
+ * The handler may modify *state (for example, to adjust the flags
+ * before passing it along to something else); it is reset for each
+ * directive.
  */
-typedef void (*fmt_specifier_t)(struct fmt_state);
+typedef void (*fmt_conv_t)(struct fmt_state *state);
+
+PICO_FMT_API void fmt_conv_putchar(struct fmt_state *state, char character);
+
+/**
+ * \brief Fetch the handler's next argument, as `type`.
+ *
+ * This is the same as `va_arg(*state->args, T)` (for whatever C type
+ * `type` names), except that it also works when formatting from an
+ * array of struct fmt_arg (fmt_fctprintf_args()), in which case
+ * state->args is NULL.  Read the member of the result that goes with
+ * `type`.
+ *
+ * If the array has no arguments left, or the next one is of the wrong
+ * kind, then this returns 0 and the formatting call returns -1 once
+ * the handler is done.
+ */
+PICO_FMT_API struct fmt_arg fmt_conv_arg(struct fmt_state *state, enum fmt_type type);
+
+/**
+ * \brief How many characters have been fmt_conv_putchar()ed so far.
+ */
+PICO_FMT_API size_t fmt_conv_len(const struct fmt_state *state);
+
+/**
+ * \brief Format the handler's output with a nested format string.
+ *
+ * The nested output goes straight to the same place as the rest of
+ * the output, without an intermediate buffer, and counts toward
+ * fmt_conv_len(); the nested directives use the same locale as the
+ * enclosing one, and take their arguments from `...` (or `va`), not
+ * from the enclosing call's.
+ *
+ * ```c
+ * static void conv_point(struct fmt_state *state) {
+ *     const struct point *pt = fmt_conv_arg(state, FMT_TYPE_PTR).p;
+ *     fmt_conv_printf(state, "(%d, %d)", pt->x, pt->y);
+ * }
+ * ```
+ *
+ * The whole of the nested output is padded out to state->width, in
+ * the same way as a "%s" (clear state->width first to not have it
+ * be).  Right-justifying it means formatting it twice, once to count
+ * it and once to output it, so any installed specifiers in the nested
+ * format must not mind being run twice.
+ *
+ * Under fmt_vfctprintf_limited(), the nested output still counts
+ * toward max_output, but is otherwise not limited.
+ *
+ * \return how many characters it output, including the padding; or
+ *         -1 if the nested format is a bad positional format
+ */
+PICO_FMT_API int fmt_conv_printf(struct fmt_state *state, const char *format, ...);
+PICO_FMT_API int fmt_conv_vprintf(struct fmt_state *state, const char *format, va_list va);
+
+/**
+ * \brief Output `len` characters from `buf`, as-is.
+ *
+ * This is the same as fmt_conv_putchar() for each of them, but copies
+ * them all at once when the output is going straight in to a buffer.
+ * It is cheaper to build up a field in an array on the stack and
+ * fmt_conv_write() it than to output it a character at a time.
+ */
+PICO_FMT_API void fmt_conv_write(struct fmt_state *state, const char *buf, size_t len);
 
-void fmt_state_putchar(struct fmt_state state, char character);
+/**
+ * \brief Output `character` `n` times; for padding.
+ */
+PICO_FMT_API void fmt_conv_pad(struct fmt_state *state, char character, size_t n);
+
+/**
+ * \brief Output an integer the way that a built-in specifier would.
+ *
+ * state's flags, width and precision apply, as they would to
+ * "%<flags><width>.<precision><specifier>".  `specifier` picks the
+ * base and the case of the digits: 'd' or 'u' for decimal, 'x' or
+ * 'X' for hexadecimal, 'o' for octal, 'b' for binary.
+ * fmt_conv_uint() ignores the '+' and ' ' flags, as "%u" does.
+ *
+ * Like the built-in conversions, these use up *state (the width, for
+ * one).  To output several numbers for one directive, give each a
+ * copy of *state with the flags and width that it should have:
+ *
+ * ```c
+ * static void conv_ipv4(struct fmt_state *state) {
+ *     const uint32_t addr = fmt_conv_arg(state, FMT_TYPE_UINT32).u;
+ *     for (int shift = 24; shift >= 0; shift -= 8) {
+ *         struct fmt_state octet = *state;
+ *         octet.flags = 0;
+ *         octet.width = 0;
+ *         fmt_conv_uint(&octet, (addr >> shift) & 0xFF, 'u');
+ *         if (shift)
+ *             fmt_conv_putchar(state, '.');
+ *     }
+ * }
+ * ```
+ */
+PICO_FMT_API void fmt_conv_int(struct fmt_state *state, long long value, char specifier);
+PICO_FMT_API void fmt_conv_uint(struct fmt_state *state, unsigned long long value, char specifier);
 
 /**
- * \brief How many characters have been fmt_state_putchar()ed so far.
+ * \brief Output a double the way that a built-in specifier would.
+ *
+ * The same as fmt_conv_int(), but for `specifier` 'f', 'F', 'e', 'E',
+ * 'g' or 'G'.  Like those, it prints "??" if printf_float.c isn't
+ * linked in.
  */
-size_t fmt_state_len(struct fmt_state state);
+PICO_FMT_API void fmt_conv_double(struct fmt_state *state, double value, char specifier);
 
 // For installing that function ////////////////////////////////////////////////
 
-void fmt_install(char character, fmt_specifier_t fn);
+/**
+ * \brief Install a handler for `character` in the default locale, which
+ * is what fmt_vfctprintf() and friends use.
+ *
+ * Installing a NULL handler makes the character print as itself.
+ *
+ * \return false if there is no room left to install another specifier
+ *         (see PICO_PRINTF_MAX_INSTALLED_SPECIFIERS); re-installing an
+ *         already-installed character does not take up more room.
+ */
+PICO_FMT_API bool fmt_install_conv(char character, fmt_conv_t fn);
+
+// Per-context specifier tables ////////////////////////////////////////////////
+
+// PICO_CONFIG: PICO_PRINTF_MAX_INSTALLED_SPECIFIERS, Define the maximum number of specifiers that may be installed in each locale, min=1, default=8, group=pico_printf
+#ifndef PICO_PRINTF_MAX_INSTALLED_SPECIFIERS
+#define PICO_PRINTF_MAX_INSTALLED_SPECIFIERS 8
+#endif
+
+/**
+ * \brief A set of installed specifiers, for use with fmt_vctxprintf().
+ *
+ * Each locale starts out with just the built-in specifiers (which are
+ * shared, and live in flash), and holds room for up to
+ * PICO_PRINTF_MAX_INSTALLED_SPECIFIERS installed specifiers.  All of
+ * the members are private.
+ *
+ * A zero-initialized locale is valid, as is one initialized with
+ * fmt_locale_init().
+ *
+ * Formatting with a locale may race with installs in to it; each
+ * lookup sees either the old or the new handler.  Installs in to the
+ * same locale must not race with each other.
+ */
+struct fmt_locale {
+    uint32_t             _installed[0x100 / 32];
+    unsigned int         _n;
+    struct _fmt_locale_entry {
+        char             character;
+        bool             legacy;
+        fmt_conv_t       fn;
+    }                    _entries[PICO_PRINTF_MAX_INSTALLED_SPECIFIERS];
+};
+
+PICO_FMT_API void fmt_locale_init(struct fmt_locale *locale);
+PICO_FMT_API bool fmt_locale_install_conv(struct fmt_locale *locale, char character, fmt_conv_t fn);
+
+// Deprecated by-value API /////////////////////////////////////////////////////
+//
+// The original handler signature took `struct fmt_state` by value,
+// which costs a copy of the struct for every directive that it
+// handles.  It is still supported, but new code should use
+// fmt_conv_t.
+
+typedef void (*fmt_specifier_t)(struct fmt_state);
+
+PICO_FMT_API void fmt_state_putchar(struct fmt_state state, char character);
+
+PICO_FMT_API size_t fmt_state_len(struct fmt_state state);
+
+PICO_FMT_API bool fmt_install(char character, fmt_specifier_t fn);
+PICO_FMT_API bool fmt_locale_install(struct fmt_locale *locale, char character, fmt_specifier_t fn);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,174 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_MAXLEN_H
+#define _PICO_FMT_MAXLEN_H
+
+#include <stddef.h>  /* for size_t */
+
+#include "pico/fmt_printf.h"
+#include "pico/fmt_install.h"
+
+/** \file fmt_maxlen.h
+ *  \defgroup pico_fmt_maxlen pico_fmt_maxlen
+ *
+ * \brief The most that a format string can print
+ *
+ * Every built-in directive has a longest output that depends only on
+ * its flags, width, precision and how wide its argument is: "%d" of
+ * an int is at most 11 characters, "%.3e" at most 12, "%08.2f" at
+ * most 14.  Only "%s" without a precision, a "*" width or precision,
+ * and installed specifiers are unbounded.
+ *
+ * ```c
+ * char buf[sizeof("temp=") - 1 + FMT_MAXLEN_DIRECTIVE('d', 0, 0, 0, 16) + 1];
+ * fmt_snprintf(buf, sizeof(buf), "temp=%hd", temp); // never truncates
+ * ```
+ *
+ * The same bound is available at run time as fmt_maxlen(), in C++ as
+ * pico::fmt::maxlen() (which is also checked by the array overload of
+ * pico::fmt::sprintf()), and for pico_fmt_generate() formatters as
+ * NAME_MAXLEN.  All of them are upper bounds; the actual output may be
+ * shorter, but never longer.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_DEFAULT_FLOAT_PRECISION, Define default floating point precision, min=1, max=16, default=6, group=pico_printf
+#ifndef PICO_PRINTF_DEFAULT_FLOAT_PRECISION
+#define PICO_PRINTF_DEFAULT_FLOAT_PRECISION  6U
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_MAX_FLOAT, Define the largest float suitable to print with %f, min=1, max=1e9, default=1e9, group=pico_printf
+#ifndef PICO_PRINTF_MAX_FLOAT
+#define PICO_PRINTF_MAX_FLOAT  1e9
+#endif
+
+/**
+ * \brief What the fmt_maxlen functions and macros give for output
+ * that has no upper bound
+ */
+#define FMT_MAXLEN_UNBOUNDED ((size_t) -1)
+
+/**
+ * \brief The most that one directive can print, not counting the NUL
+ *
+ * Each argument must be a constant expression for the result to be
+ * one.
+ *
+ * \param specifier The specifier character, e.g. 'd'
+ * \param flags     FMT_FLAG_* (with FMT_FLAG_PRECISION if there is a precision)
+ * \param width     The width, or 0
+ * \param precision The precision; ignored without FMT_FLAG_PRECISION
+ * \param bits      How wide the argument is, e.g. `sizeof(long) * CHAR_BIT`;
+ *                  only used by the integer specifiers
+ * \return FMT_MAXLEN_UNBOUNDED for "%s" without a precision
+ */
+#define FMT_MAXLEN_DIRECTIVE(specifier, flags, width, precision, bits)                                  \
+    ((specifier) == 's' ? ((flags) & FMT_FLAG_PRECISION                                                 \
+                           ? _FMT_MAXLEN_MAX((size_t) (width), (size_t) (precision))                    \
+                           : FMT_MAXLEN_UNBOUNDED)                                                      \
+     : (specifier) == 'c' ? _FMT_MAXLEN_MAX((size_t) (width), 1U)                                       \
+     : (specifier) == 'p' ? _FMT_MAXLEN_PTR(flags, precision)                                           \
+     : _FMT_MAXLEN_IS_INT(specifier) ? _FMT_MAXLEN_INT(specifier, flags, width, precision, bits)       \
+     : _FMT_MAXLEN_IS_FLOAT(specifier) ? _FMT_MAXLEN_MAX((size_t) (width),                              \
+                                                         _FMT_MAXLEN_FLOAT(specifier, flags, precision)) \
+     : (size_t) 1U)
+
+// The rest is FMT_MAXLEN_DIRECTIVE()'s working.  Each is worked out
+// from what printf.c and printf_float.c actually print.
+
+#define _FMT_MAXLEN_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+#define _FMT_MAXLEN_IS_INT(specifier) \
+    ((specifier) == 'd' || (specifier) == 'i' || (specifier) == 'u' || \
+     (specifier) == 'x' || (specifier) == 'X' || (specifier) == 'o' || (specifier) == 'b')
+#define _FMT_MAXLEN_IS_FLOAT(specifier) \
+    ((specifier) == 'f' || (specifier) == 'F' || (specifier) == 'e' || \
+     (specifier) == 'E' || (specifier) == 'g' || (specifier) == 'G')
+
+#define _FMT_MAXLEN_BASE(specifier) \
+    ((specifier) == 'x' || (specifier) == 'X' ? 16U : (specifier) == 'o' ? 8U : (specifier) == 'b' ? 2U : 10U)
+
+// digits in the largest bits-bit unsigned number (1233/4096 is just
+// over log10(2), and exact up to 256 bits)
+#define _FMT_MAXLEN_DIGITS(bits, base)                             \
+    ((base) == 10U ? (size_t) (bits) * 1233U / 4096U + 1U          \
+     : (base) == 16U ? ((size_t) (bits) + 3U) / 4U                 \
+     : (base) == 8U ? ((size_t) (bits) + 2U) / 3U                  \
+     : (size_t) (bits))
+
+// the sign, the "#" prefix, and the digits or the precision's zeros;
+// "%d" of the most negative number has a digit less than "%u" of the
+// same width would.  (A zero-padded "%#b" only makes room in the width
+// for one of the two characters of its "0b".)
+#define _FMT_MAXLEN_INT(specifier, flags, width, precision, bits)                                             \
+    _FMT_MAXLEN_MAX((size_t) (width) + ((flags) & FMT_FLAG_HASH && (specifier) == 'b' ? 1U : 0U),            \
+        ((specifier) == 'd' || (specifier) == 'i' ? 1U : 0U)                                                  \
+        + ((flags) & FMT_FLAG_HASH && _FMT_MAXLEN_BASE(specifier) != 10U                                      \
+           ? (_FMT_MAXLEN_BASE(specifier) == 8U ? 1U : 2U) : 0U)                                              \
+        + _FMT_MAXLEN_MAX((flags) & FMT_FLAG_PRECISION ? (size_t) (precision) : 0U,                           \
+                          _FMT_MAXLEN_DIGITS((specifier) == 'd' || (specifier) == 'i' ? (bits) - 1U : (bits), \
+                                             _FMT_MAXLEN_BASE(specifier))))
+
+// "%p" is zero-padded to the width of a pointer, whatever the width
+#define _FMT_MAXLEN_PTR(flags, precision)                                    \
+    (((flags) & (FMT_FLAG_PLUS | FMT_FLAG_SPACE) ? 1U : 0U)                  \
+     + ((flags) & FMT_FLAG_HASH ? 2U : 0U)                                   \
+     + _FMT_MAXLEN_MAX((flags) & FMT_FLAG_PRECISION ? (size_t) (precision) : 0U, \
+                       sizeof(void *) * 2U))
+
+#define _FMT_MAXLEN_PREC(flags, precision) \
+    ((flags) & FMT_FLAG_PRECISION ? (size_t) (precision) : (size_t) PICO_PRINTF_DEFAULT_FLOAT_PRECISION)
+
+// the "." and the fraction
+#define _FMT_MAXLEN_FRAC(p) ((p) ? 1U + (p) : 0U)
+
+// the whole part of "%f" is at most PICO_PRINTF_MAX_FLOAT, plus one
+// if the fraction rounds up in to it
+#define _FMT_MAXLEN_DIGITS10(n)                                                       \
+    ((n) < 10U ? 1U : (n) < 100U ? 2U : (n) < 1000U ? 3U : (n) < 10000U ? 4U :        \
+     (n) < 100000U ? 5U : (n) < 1000000U ? 6U : (n) < 10000000U ? 7U :                \
+     (n) < 100000000U ? 8U : (n) < 1000000000U ? 9U : 10U)
+#define _FMT_MAXLEN_WHOLE _FMT_MAXLEN_DIGITS10((unsigned long long) (PICO_PRINTF_MAX_FLOAT) + 1U)
+
+// sign, whole, fraction
+#define _FMT_MAXLEN_FIXED(p) (1U + _FMT_MAXLEN_WHOLE + _FMT_MAXLEN_FRAC(p))
+// sign, 1 or (once rounded up) 2 digits, fraction, "e", sign, 2 or 3 digits
+#define _FMT_MAXLEN_EXP(p) (1U + 2U + _FMT_MAXLEN_FRAC(p) + 5U)
+
+// "%f" of anything over PICO_PRINTF_MAX_FLOAT is "%e"; "%g" is either
+// "%f" of something under 1e6 (to at most p significant digits, and
+// at most "0.000" before them) or "%e" with one digit less
+#define _FMT_MAXLEN_FLOAT(specifier, flags, precision)                                                 \
+    ((specifier) == 'f' || (specifier) == 'F'                                                          \
+     ? _FMT_MAXLEN_MAX(_FMT_MAXLEN_FIXED(_FMT_MAXLEN_PREC(flags, precision)),                          \
+                       _FMT_MAXLEN_EXP(_FMT_MAXLEN_PREC(flags, precision)))                            \
+     : (specifier) == 'e' || (specifier) == 'E'                                                        \
+     ? _FMT_MAXLEN_EXP(_FMT_MAXLEN_PREC(flags, precision))                                             \
+     : _FMT_MAXLEN_MAX(_FMT_MAXLEN_MAX(_FMT_MAXLEN_PREC(flags, precision) + 6U, (size_t) 8U),          \
+                       _FMT_MAXLEN_EXP((flags) & FMT_FLAG_PRECISION && (precision)                     \
+                                       ? (size_t) (precision) - 1U                                     \
+                                       : _FMT_MAXLEN_PREC(flags, precision))))
+
+/**
+ * \brief The most that fmt_printf(format, ...) can print, not counting
+ * the NUL
+ *
+ * The length modifiers say how wide each integer argument is, the
+ * same as they do for printf.  This is for the default locale;
+ * installed specifiers are taken to be unbounded.
+ *
+ * \return FMT_MAXLEN_UNBOUNDED if the output is unbounded: if there
+ *         is a "%s" without a precision, a "*" width or precision, or
+ *         an installed specifier
+ */
+size_t fmt_maxlen(const char *format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _PICO_FMT_MAXLEN_H
@@ -50,6 +50,13 @@
  * \brief Compact replacement for printf by Marco Paland (info@paland.com)
  */
 
+// Each of pico_fmt's functions is declared and defined with
+// PICO_FMT_API in front of it; the single-header pico_fmt.h (the
+// pico_fmt_single library) makes them `static inline`.
+#ifndef PICO_FMT_API
+#define PICO_FMT_API
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -67,18 +74,202 @@ typedef void (*fmt_fct_t)(char character, void *arg);
  * \param out An output function which takes one character and an argument pointer
  * \param arg An argument pointer for user data passed to output function
  * \param format A string that specifies the format of the output
- * \return The number of characters that are sent to the output function, not counting the terminating null character
+ * \return The number of characters that are sent to the output function, not counting the terminating null character;
+ * or -1 if the format uses "%N$" positional arguments wrongly (see README.md)
+ */
+PICO_FMT_API int fmt_vfctprintf(fmt_fct_t out, void *arg, const char *format, va_list va);
+
+struct fmt_locale;
+
+/**
+ * \brief vprintf with output function and a specific table of
+ * specifiers (see <pico/fmt_install.h>)
+ *
+ * \param locale The specifier table to use, or NULL for the default one
+ *        (the same as fmt_vfctprintf())
+ */
+PICO_FMT_API int fmt_vctxprintf(const struct fmt_locale *locale, fmt_fct_t out, void *arg, const char *format, va_list va);
+
+// Argument arrays /////////////////////////////////////////////////////////////
+
+enum fmt_type {
+    FMT_TYPE_INT,     // int
+    FMT_TYPE_UINT,    // unsigned int
+    FMT_TYPE_LONG,    // long
+    FMT_TYPE_ULONG,   // unsigned long
+    FMT_TYPE_LLONG,   // long long
+    FMT_TYPE_ULLONG,  // unsigned long long
+    FMT_TYPE_INT8,    // int8_t
+    FMT_TYPE_UINT8,   // uint8_t
+    FMT_TYPE_INT16,   // int16_t
+    FMT_TYPE_UINT16,  // uint16_t
+    FMT_TYPE_INT32,   // int32_t
+    FMT_TYPE_UINT32,  // uint32_t
+    FMT_TYPE_INT64,   // int64_t
+    FMT_TYPE_UINT64,  // uint64_t
+    FMT_TYPE_SIZE,    // size_t
+    FMT_TYPE_CHAR,    // char
+    FMT_TYPE_FLOAT,   // float
+    FMT_TYPE_DOUBLE,  // double
+    FMT_TYPE_STR,     // const char *
+    FMT_TYPE_PTR,     // const void *
+};
+
+/**
+ * \brief An argument, tagged with its type
+ */
+struct fmt_arg {
+    enum fmt_type        type;
+    union {
+        long long            i; // the signed integer types, and FMT_TYPE_CHAR
+        unsigned long long   u; // the unsigned integer types
+        double               f; // FMT_TYPE_FLOAT, FMT_TYPE_DOUBLE
+        const char          *s; // FMT_TYPE_STR
+        const void          *p; // FMT_TYPE_PTR
+    };
+};
+
+#define FMT_ARG_INT(x)    ((struct fmt_arg){ .type = FMT_TYPE_INT,    .i = (x) })
+#define FMT_ARG_UINT(x)   ((struct fmt_arg){ .type = FMT_TYPE_UINT,   .u = (x) })
+#define FMT_ARG_LONG(x)   ((struct fmt_arg){ .type = FMT_TYPE_LONG,   .i = (x) })
+#define FMT_ARG_ULONG(x)  ((struct fmt_arg){ .type = FMT_TYPE_ULONG,  .u = (x) })
+#define FMT_ARG_LLONG(x)  ((struct fmt_arg){ .type = FMT_TYPE_LLONG,  .i = (x) })
+#define FMT_ARG_ULLONG(x) ((struct fmt_arg){ .type = FMT_TYPE_ULLONG, .u = (x) })
+#define FMT_ARG_SIZE(x)   ((struct fmt_arg){ .type = FMT_TYPE_SIZE,   .u = (x) })
+#define FMT_ARG_CHAR(x)   ((struct fmt_arg){ .type = FMT_TYPE_CHAR,   .i = (x) })
+#define FMT_ARG_DOUBLE(x) ((struct fmt_arg){ .type = FMT_TYPE_DOUBLE, .f = (x) })
+#define FMT_ARG_STR(x)    ((struct fmt_arg){ .type = FMT_TYPE_STR,    .s = (x) })
+#define FMT_ARG_PTR(x)    ((struct fmt_arg){ .type = FMT_TYPE_PTR,    .p = (x) })
+
+/**
+ * \brief printf with output function, taking the arguments from an
+ * array rather than a va_list
+ *
+ * Because the arguments aren't consumed, the same array may be
+ * formatted any number of times.  Each argument's type takes the place
+ * of the length modifier ("l", "ll", "z", ...), which is accepted but
+ * ignored; otherwise an argument is converted the same way as if it
+ * had been passed to fmt_fctprintf() as that type.  So "%d" prints an
+ * unsigned argument's own value (never a negative number), and "%x"
+ * of a negative int8_t prints two digits, as "%hhx" would.
+ *
+ * \return The number of characters that are sent to the output
+ * function, not counting the terminating null character; or -1 if a
+ * directive has no argument left for it or an argument of the wrong
+ * kind (e.g. a string for "%d"), in which case the output stops there
+ */
+PICO_FMT_API int fmt_fctprintf_args(fmt_fct_t out, void *arg, const char *format, const struct fmt_arg *args, size_t n);
+PICO_FMT_API int fmt_ctxprintf_args(const struct fmt_locale *locale, fmt_fct_t out, void *arg, const char *format,
+                       const struct fmt_arg *args, size_t n);
+PICO_FMT_API int fmt_snprintf_args(char *buffer, size_t count, const char *format, const struct fmt_arg *args, size_t n);
+
+// Pre-parsed formats //////////////////////////////////////////////////////////
+
+/**
+ * \brief One directive of a format that has been parsed ahead of time,
+ * along with the literal text before it
+ *
+ * For example, "a=%5d b=%s\n" is the three specs
+ * `{"a=", 2, 0, 5, 0, 'd'}, {" b=", 3, 0, 0, 0, 's'}, {"\n", 1, 0, 0, 0, '\0'}`.
+ * <pico/fmt_printf.hpp> builds these at compile time.
+ */
+struct fmt_spec {
+    const char          *lit;       // literal text that comes first
+    size_t               lit_len;
+    unsigned int         flags;     // FMT_FLAG_* (<pico/fmt_install.h>) and FMT_SPEC_*_STAR
+    unsigned int         width;
+    unsigned int         precision; // if flags has FMT_FLAG_PRECISION
+    char                 specifier; // a built-in specifier, or '\0' for just the literal
+};
+
+#define FMT_SPEC_WIDTH_STAR (1U << 8U) // the width is the next argument
+#define FMT_SPEC_PREC_STAR  (1U << 9U) // the precision is the next argument
+
+/**
+ * \brief Like fmt_fctprintf_args(), but for a format that has already
+ * been parsed in to `n` specs
+ *
+ * Nothing is checked: `args` must have as many arguments as the specs
+ * call for, each of a kind that suits its directive.  Installed
+ * specifiers aren't looked up.
+ *
+ * \return The number of characters that are sent to the output
+ * function, not counting the terminating null character
+ */
+PICO_FMT_API int fmt_fctprintf_spec(fmt_fct_t out, void *arg, const struct fmt_spec *specs, size_t n, const struct fmt_arg *args);
+PICO_FMT_API int fmt_snprintf_spec(char *buffer, size_t count, const struct fmt_spec *specs, size_t n, const struct fmt_arg *args);
+
+// Bounded formatting ////////////////////////////////////////////////////////
+
+/**
+ * \brief Hard caps for fmt_vfctprintf_limited(); each is exactly the
+ * most that is allowed (so a zero-initialized struct fmt_limits allows
+ * nothing at all)
+ */
+struct fmt_limits {
+    size_t               max_output;     // the most characters sent to the output function
+    unsigned int         max_width;      // widths (including "*" ones) are cut to this
+    unsigned int         max_precision;  // precisions are cut to this, and "%s" prints at most this much
+    unsigned int         max_directives; // formatting stops before any more than this many
+};
+
+/**
+ * \brief What fmt_vfctprintf_limited() and co. return if any of the
+ * limits were reached
+ */
+#define FMT_LIMITED (-2)
+
+/**
+ * \brief vprintf with output function, for where the worst-case
+ * execution time matters (e.g. in an interrupt handler)
+ *
+ * The same as fmt_vfctprintf(), but nothing about the arguments (how
+ * long a "%s" string is, how big a "*" width is) can make it take
+ * longer than the limits allow:
+ *
+ *  - the output function is called at most `max_output` times, and
+ *    formatting stops at the first directive after that many
+ *    characters;
+ *  - at most `max_directives` directives are formatted;
+ *  - widths and precisions are cut to `max_width` and
+ *    `max_precision`, and a "%s" without a precision is read and
+ *    printed up to `max_precision` characters of (and, since whether
+ *    there was more isn't known without reading further, counts as
+ *    having reached the limit if it is that long).
+ *
+ * So every directive generates at most `max_width + max_precision +
+ * 67` characters, and the whole call does work linear in
+ *
+ *     strlen(format) + max_directives * (max_width + max_precision + 67)
+ *
+ * whatever the arguments are.  (Installed specifiers, which run their
+ * own code, are the exception; they are given the cut-down width and
+ * precision, but are otherwise unbounded.)  "%N$" positional formats
+ * are not supported here.
+ *
+ * \return The number of characters that are sent to the output
+ * function, as for fmt_vfctprintf(); or FMT_LIMITED if any of the
+ * limits were reached (what was output up to then stands); or -1 for a
+ * "%N$" positional format
  */
-int fmt_vfctprintf(fmt_fct_t out, void *arg, const char *format, va_list va);
+PICO_FMT_API int fmt_vfctprintf_limited(const struct fmt_limits *limits, fmt_fct_t out, void *arg,
+                                        const char *format, va_list va);
+PICO_FMT_API int fmt_fctprintf_limited(const struct fmt_limits *limits, fmt_fct_t out, void *arg,
+                                       const char *format, ...);
+PICO_FMT_API int fmt_vsnprintf_limited(const struct fmt_limits *limits, char *buffer, size_t count,
+                                       const char *format, va_list va);
+PICO_FMT_API int fmt_snprintf_limited(const struct fmt_limits *limits, char *buffer, size_t count,
+                                      const char *format, ...);
 
 // Convenience functions ///////////////////////////////////////////////////////
 
-int fmt_fctprintf(fmt_fct_t out, void *arg, const char *format, ...);
+PICO_FMT_API int fmt_fctprintf(fmt_fct_t out, void *arg, const char *format, ...);
+PICO_FMT_API int fmt_ctxprintf(const struct fmt_locale *locale, fmt_fct_t out, void *arg, const char *format, ...);
 
-int fmt_vsnprintf(char *buffer, size_t count, const char *format, va_list);
-int fmt_snprintf(char *buffer, size_t count, const char *format, ...);
-int fmt_vsprintf(char *buffer, const char *format, va_list);
-int fmt_sprintf(char *buffer, const char *format, ...);
+PICO_FMT_API int fmt_vsnprintf(char *buffer, size_t count, const char *format, va_list);
+PICO_FMT_API int fmt_snprintf(char *buffer, size_t count, const char *format, ...);
+PICO_FMT_API int fmt_vsprintf(char *buffer, const char *format, va_list);
+PICO_FMT_API int fmt_sprintf(char *buffer, const char *format, ...);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,404 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_PRINTF_HPP
+#define _PICO_FMT_PRINTF_HPP
+
+#include <array>       // for std::array
+#include <climits>     // for CHAR_BIT
+#include <cstddef>     // for std::size_t, std::nullptr_t
+#include <type_traits> // for std::is_integral et c.
+#include <utility>     // for std::index_sequence
+
+#include "pico/fmt_printf.h"
+#include "pico/fmt_install.h"
+#include "pico/fmt_maxlen.h"
+
+/** \file fmt_printf.hpp
+ *  \defgroup pico_fmt_cxx pico_fmt_cxx
+ *
+ * \brief printf-syntax formatting for C++17, parsed at compile time
+ *
+ * ```c++
+ * pico::fmt::snprintf(buf, sizeof(buf), PICO_FMT("id=%u temp=%5d %s"), id, temp, name);
+ * ```
+ *
+ * The format is parsed by the compiler, in to a constexpr table of
+ * struct fmt_spec that goes straight to fmt_fctprintf_spec(); there is
+ * no va_list and nothing is parsed at run time.  The number of
+ * arguments and whether each one's type suits its directive (an
+ * integer for "%d", a `const char *` for "%s", ...) are checked with
+ * static_assert.  As with fmt_fctprintf_args(), an argument's own type
+ * takes the place of the length modifier, which is accepted but
+ * ignored.
+ *
+ * Only the built-in specifiers may be used (installed ones can't be
+ * known at compile time), and not "%N$".
+ *
+ * The format has to be wrapped in PICO_FMT() because C++17 can't take a
+ * string literal as a template argument.
+ *
+ * Since the format and the argument types are both known at compile
+ * time, so is the most that they can print (see <pico/fmt_maxlen.h>):
+ *
+ * ```c++
+ * char buf[pico::fmt::maxlen<uint32_t, int16_t>(PICO_FMT("id=%u temp=%5d")) + 1];
+ * pico::fmt::sprintf(buf, PICO_FMT("id=%u temp=%5d"), id, temp);
+ * ```
+ *
+ * pico::fmt::sprintf() into an array checks with static_assert that
+ * the array is big enough, so that output can never be truncated.
+ */
+
+/**
+ * \brief A format string, for the pico::fmt functions
+ */
+#define PICO_FMT(str) ([] {                                             \
+        struct _pico_fmt_str {                                          \
+            static constexpr const char *get() { return str; }          \
+        };                                                              \
+        return _pico_fmt_str{};                                         \
+    }())
+
+namespace pico::fmt {
+
+namespace detail {
+
+// what an argument has to be
+enum class kind { integer, floating, string, pointer };
+
+struct directive {
+    fmt_spec             spec;
+    unsigned int         nargs;   // 0-3, stars first
+    kind                 kinds[3];
+    bool                 ok;
+};
+
+constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// Parse the directive at f[i] (just past the '%'), advancing i past it.
+constexpr directive parse_directive(const char *f, std::size_t &i) {
+    directive d{};
+    d.ok = true;
+    for (;; i++) {
+        switch (f[i]) {
+            case '0': d.spec.flags |= FMT_FLAG_ZEROPAD; continue;
+            case '-': d.spec.flags |= FMT_FLAG_LEFT;    continue;
+            case '+': d.spec.flags |= FMT_FLAG_PLUS;    continue;
+            case ' ': d.spec.flags |= FMT_FLAG_SPACE;   continue;
+            case '#': d.spec.flags |= FMT_FLAG_HASH;    continue;
+        }
+        break;
+    }
+    if (f[i] == '*') {
+        d.spec.flags |= FMT_SPEC_WIDTH_STAR;
+        d.kinds[d.nargs++] = kind::integer;
+        i++;
+    } else {
+        for (; is_digit(f[i]); i++) {
+            d.spec.width = d.spec.width * 10U + (unsigned int) (f[i] - '0');
+        }
+    }
+    if (f[i] == '.') {
+        d.spec.flags |= FMT_FLAG_PRECISION;
+        i++;
+        if (f[i] == '*') {
+            d.spec.flags |= FMT_SPEC_PREC_STAR;
+            d.kinds[d.nargs++] = kind::integer;
+            i++;
+        } else {
+            for (; is_digit(f[i]); i++) {
+                d.spec.precision = d.spec.precision * 10U + (unsigned int) (f[i] - '0');
+            }
+        }
+    }
+    switch (f[i]) {
+        case 'l': case 'h':
+            if (f[i+1] == f[i]) {
+                i++;
+            }
+            i++;
+            break;
+        case 'j': case 'z': case 't':
+            i++;
+            break;
+    }
+    d.spec.specifier = f[i];
+    switch (f[i]) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'b': case 'c':
+            d.kinds[d.nargs++] = kind::integer;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            d.kinds[d.nargs++] = kind::floating;
+            break;
+        case 's':
+            d.kinds[d.nargs++] = kind::string;
+            break;
+        case 'p':
+            d.kinds[d.nargs++] = kind::pointer;
+            break;
+        case '%':
+            break;
+        default: // the end of the string, "$", or not a built-in
+            d.ok = false;
+            return d;
+    }
+    i++;
+    return d;
+}
+
+constexpr std::size_t count_specs(const char *f) {
+    std::size_t n = 1; // the trailing literal
+    for (std::size_t i = 0; f[i]; ) {
+        if (f[i++] == '%') {
+            parse_directive(f, i);
+            n++;
+        }
+    }
+    return n;
+}
+
+template <std::size_t N>
+struct parsed {
+    std::array<fmt_spec, N> specs{};
+    std::array<kind, 3 * N> kinds{};
+    std::size_t          nargs = 0;
+    bool                 ok = true;
+};
+
+template <std::size_t N>
+constexpr parsed<N> parse(const char *f) {
+    parsed<N> p{};
+    std::size_t n = 0;
+    std::size_t lit = 0;
+    for (std::size_t i = 0; f[i]; ) {
+        if (f[i] != '%') {
+            i++;
+            continue;
+        }
+        const std::size_t lit_len = i - lit;
+        i++;
+        const directive d = parse_directive(f, i);
+        if (!d.ok) {
+            p.ok = false;
+            return p;
+        }
+        p.specs[n] = d.spec;
+        p.specs[n].lit = &f[lit];
+        p.specs[n].lit_len = lit_len;
+        n++;
+        for (unsigned int a = 0; a < d.nargs; a++) {
+            p.kinds[p.nargs++] = d.kinds[a];
+        }
+        lit = i;
+    }
+    std::size_t end = lit;
+    while (f[end]) {
+        end++;
+    }
+    p.specs[n].lit = &f[lit];
+    p.specs[n].lit_len = end - lit;
+    return p;
+}
+
+template <class S>
+struct format {
+    static constexpr const char *str = S::get();
+    static constexpr std::size_t n = count_specs(str);
+    static constexpr parsed<n> p = parse<n>(str);
+};
+
+// The C types, and what fmt_type each is passed as
+
+template <class T, class = void>
+struct arg_traits {
+    static constexpr bool supported = false;
+};
+
+template <class T>
+struct arg_traits<T, std::enable_if_t<std::is_integral_v<T>>> {
+    static constexpr bool supported = true;
+    static constexpr kind k = kind::integer;
+    static constexpr fmt_type type =
+        std::is_same_v<T, char>           ? FMT_TYPE_CHAR  :
+        std::is_same_v<T, bool>           ? FMT_TYPE_INT   :
+        sizeof(T) == 1 ? (std::is_signed_v<T> ? FMT_TYPE_INT8  : FMT_TYPE_UINT8)  :
+        sizeof(T) == 2 ? (std::is_signed_v<T> ? FMT_TYPE_INT16 : FMT_TYPE_UINT16) :
+        sizeof(T) == 4 ? (std::is_signed_v<T> ? FMT_TYPE_INT32 : FMT_TYPE_UINT32) :
+                         (std::is_signed_v<T> ? FMT_TYPE_INT64 : FMT_TYPE_UINT64);
+    static fmt_arg make(T v) {
+        fmt_arg a{};
+        a.type = type;
+        if constexpr (std::is_signed_v<T>) {
+            a.i = v;
+        } else {
+            a.u = v;
+        }
+        return a;
+    }
+};
+
+template <class T>
+struct arg_traits<T, std::enable_if_t<std::is_enum_v<T>>> : arg_traits<std::underlying_type_t<T>> {
+    static fmt_arg make(T v) {
+        return arg_traits<std::underlying_type_t<T>>::make(static_cast<std::underlying_type_t<T>>(v));
+    }
+};
+
+template <class T>
+struct arg_traits<T, std::enable_if_t<std::is_same_v<T, float> || std::is_same_v<T, double>>> {
+    static constexpr bool supported = true;
+    static constexpr kind k = kind::floating;
+    static fmt_arg make(T v) {
+        fmt_arg a{};
+        a.type = std::is_same_v<T, float> ? FMT_TYPE_FLOAT : FMT_TYPE_DOUBLE;
+        a.f = v;
+        return a;
+    }
+};
+
+template <class T>
+struct arg_traits<T *, std::enable_if_t<std::is_same_v<std::remove_cv_t<T>, char>>> {
+    static constexpr bool supported = true;
+    static constexpr kind k = kind::string;
+    static fmt_arg make(const char *v) {
+        fmt_arg a{};
+        a.type = FMT_TYPE_STR;
+        a.s = v;
+        return a;
+    }
+};
+
+template <class T>
+struct arg_traits<T *, std::enable_if_t<!std::is_same_v<std::remove_cv_t<T>, char>>> {
+    static constexpr bool supported = true;
+    static constexpr kind k = kind::pointer;
+    static fmt_arg make(const volatile void *v) {
+        fmt_arg a{};
+        a.type = FMT_TYPE_PTR;
+        a.p = const_cast<const void *>(v);
+        return a;
+    }
+};
+
+template <>
+struct arg_traits<std::nullptr_t> : arg_traits<void *> {};
+
+// arrays (string literals and char buffers) are passed as pointers
+template <class T>
+using arg_t = std::decay_t<T>;
+
+constexpr bool suits(kind want, kind have) {
+    return want == have || (want == kind::pointer && have == kind::string);
+}
+
+template <class F, class... Args, std::size_t... I>
+constexpr bool check(std::index_sequence<I...>) {
+    return (suits(F::p.kinds[I], arg_traits<arg_t<Args>>::k) && ...);
+}
+
+// each check only once the ones before it have passed, for one error at a time
+template <class F, class... Args>
+constexpr void validate() {
+    static_assert(F::p.ok, "pico::fmt: bad directive in format (only built-in specifiers are supported)");
+    static_assert((arg_traits<arg_t<Args>>::supported && ...), "pico::fmt: unsupported argument type");
+    if constexpr (F::p.ok && (arg_traits<arg_t<Args>>::supported && ...)) {
+        static_assert(F::p.nargs == sizeof...(Args), "pico::fmt: wrong number of arguments for format");
+        if constexpr (F::p.nargs == sizeof...(Args)) {
+            static_assert(check<F, Args...>(std::index_sequence_for<Args...>{}),
+                          "pico::fmt: an argument's type doesn't suit its directive");
+        }
+    }
+}
+
+// how wide an integer argument is, for FMT_MAXLEN_DIRECTIVE()
+template <class T>
+constexpr unsigned int arg_bits() {
+    if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        return sizeof(T) * CHAR_BIT;
+    } else {
+        return 0;
+    }
+}
+
+template <class F, class... Args>
+constexpr std::size_t maxlen() {
+    constexpr unsigned int bits[] = { arg_bits<arg_t<Args>>()..., 0 };
+    std::size_t total = 0;
+    std::size_t a = 0;
+    for (std::size_t n = 0; n < F::n; n++) {
+        const fmt_spec &s = F::p.specs[n];
+        total += s.lit_len;
+        if (!s.specifier) {
+            continue;
+        }
+        if (s.flags & (FMT_SPEC_WIDTH_STAR | FMT_SPEC_PREC_STAR)) {
+            return FMT_MAXLEN_UNBOUNDED;
+        }
+        const unsigned int b = s.specifier == '%' || a == sizeof...(Args) ? 0 : bits[a++];
+        const std::size_t len = FMT_MAXLEN_DIRECTIVE(s.specifier, s.flags, s.width, s.precision, b);
+        if (len == FMT_MAXLEN_UNBOUNDED) {
+            return FMT_MAXLEN_UNBOUNDED;
+        }
+        total += len;
+    }
+    return total;
+}
+
+} // namespace detail
+
+/**
+ * \brief The most that formatting S with arguments of types Args can
+ * print, not counting the NUL; FMT_MAXLEN_UNBOUNDED if there is a
+ * "%s" without a precision or a "*" width or precision
+ *
+ * ```c++
+ * constexpr std::size_t n = pico::fmt::maxlen<int, const char *>(PICO_FMT("%d %.8s"));
+ * ```
+ */
+template <class... Args, class S>
+constexpr std::size_t maxlen(S) {
+    using F = detail::format<S>;
+    detail::validate<F, Args...>();
+    return detail::maxlen<F, Args...>();
+}
+
+/**
+ * \brief printf with output function; see fmt_fctprintf_args()
+ */
+template <class S, class... Args>
+inline int fctprintf(fmt_fct_t out, void *arg, S, const Args &...args) {
+    using F = detail::format<S>;
+    detail::validate<F, Args...>();
+    const fmt_arg argv[sizeof...(Args) + 1] = { detail::arg_traits<detail::arg_t<Args>>::make(args)..., {} };
+    return fmt_fctprintf_spec(out, arg, F::p.specs.data(), F::n, argv);
+}
+
+/**
+ * \brief snprintf; see fmt_snprintf_args()
+ */
+template <class S, class... Args>
+inline int snprintf(char *buffer, std::size_t count, S, const Args &...args) {
+    using F = detail::format<S>;
+    detail::validate<F, Args...>();
+    const fmt_arg argv[sizeof...(Args) + 1] = { detail::arg_traits<detail::arg_t<Args>>::make(args)..., {} };
+    return fmt_snprintf_spec(buffer, count, F::p.specs.data(), F::n, argv);
+}
+
+/**
+ * \brief sprintf into an array that is checked, at compile time, to
+ * be big enough for anything that the format can print; see maxlen()
+ */
+template <class S, std::size_t N, class... Args>
+inline int sprintf(char (&buffer)[N], S, const Args &...args) {
+    using F = detail::format<S>;
+    detail::validate<F, Args...>();
+    static_assert(detail::maxlen<F, Args...>() < N,
+                  "pico::fmt: the buffer is too small for the format (or its output is unbounded)");
+    const fmt_arg argv[sizeof...(Args) + 1] = { detail::arg_traits<detail::arg_t<Args>>::make(args)..., {} };
+    return fmt_snprintf_spec(buffer, N, F::p.specs.data(), F::n, argv);
+}
+
+} // namespace pico::fmt
+
+#endif // _PICO_FMT_PRINTF_HPP
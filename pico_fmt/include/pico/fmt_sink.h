@@ -0,0 +1,260 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef _PICO_FMT_SINK_H
+#define _PICO_FMT_SINK_H
+
+#include <stdarg.h>  /* for va_list */
+#include <stdbool.h> /* for bool */
+#include <stddef.h>  /* for size_t */
+#include <stdint.h>  /* for uint{8,16,32}_t */
+
+#include "pico/fmt_printf.h"
+
+/** \file fmt_sink.h
+ *  \defgroup pico_fmt_sink pico_fmt_sink
+ *
+ * \brief Composable chunk-at-a-time output pipelines
+ *
+ * A sink is anything that accepts chunks of bytes.  Stages are sinks
+ * that transform the chunks and pass them on to a `next` sink; they
+ * may be chained together to build up a pipeline:
+ *
+ * ```c
+ * struct fmt_sink_fct uart, flash;
+ * struct fmt_sink *outs[] = {
+ *     fmt_sink_fct_init(&uart, uart_putc, NULL),
+ *     fmt_sink_fct_init(&flash, flash_putc, NULL),
+ * };
+ * struct fmt_sink_tee tee;
+ * struct fmt_sink_cobs cobs;
+ * struct fmt_sink_crc32 crc;
+ * struct fmt_sink *pipe =
+ *     fmt_sink_crc32_init(&crc, fmt_sink_cobs_init(&cobs, fmt_sink_tee_init(&tee, outs, 2)), true);
+ *
+ * fmt_sinkprintf(pipe, "temp=%d\n", temp);
+ * fmt_sink_flush(pipe); // append the CRC, end the COBS frame
+ * ```
+ *
+ * None of the stages allocate; all state lives in the stage structs,
+ * which the caller owns.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Core API ////////////////////////////////////////////////////////////////////
+
+struct fmt_sink {
+    /**
+     * \brief Accept `len` bytes; `len` is never 0.
+     */
+    void (*write)(struct fmt_sink *self, const char *buf, size_t len);
+    /**
+     * \brief Mark the end of a message; may be NULL if the sink
+     * doesn't care about message boundaries.
+     */
+    void (*flush)(struct fmt_sink *self);
+};
+
+void fmt_sink_write(struct fmt_sink *sink, const char *buf, size_t len);
+void fmt_sink_flush(struct fmt_sink *sink);
+
+// PICO_CONFIG: PICO_PRINTF_SINK_BUFFER_SIZE, Define the size of the on-stack staging buffer used by fmt_vsinkprintf, min=1, default=64, group=pico_printf
+#ifndef PICO_PRINTF_SINK_BUFFER_SIZE
+#define PICO_PRINTF_SINK_BUFFER_SIZE 64U
+#endif
+
+/**
+ * \brief vprintf to a sink
+ *
+ * The output is staged in a PICO_PRINTF_SINK_BUFFER_SIZE-byte buffer
+ * on the stack and handed to the sink a chunk at a time.  This does
+ * not fmt_sink_flush() the sink; call that yourself once the message
+ * is complete.
+ *
+ * \return The number of characters written to the sink
+ */
+int fmt_vsinkprintf(struct fmt_sink *sink, const char *format, va_list va);
+int fmt_sinkprintf(struct fmt_sink *sink, const char *format, ...);
+/**
+ * \brief Like fmt_sinkprintf(), but taking the arguments from an array;
+ * see fmt_fctprintf_args()
+ */
+int fmt_sinkprintf_args(struct fmt_sink *sink, const char *format, const struct fmt_arg *args, size_t n);
+
+// Format-then-lock ////////////////////////////////////////////////////////////
+
+struct fmt_lock {
+    void (*acquire)(void *arg);
+    void (*release)(void *arg);
+    void                *arg;
+};
+
+/**
+ * \brief vprintf to a shared sink, holding `lock` only while handing
+ * off the finished output
+ *
+ * The output is formatted in to `buf` without holding the lock; `buf`
+ * should be per-thread (e.g. on the stack), or per-core if nothing can
+ * preempt the call.  Then the lock is acquired just long enough to
+ * write the output to `sink` as a single chunk and fmt_sink_flush()
+ * it.
+ *
+ * Output longer than `cap` bytes falls back to acquiring the lock as
+ * soon as `buf` fills, and holding it for the rest of the call while
+ * passing the output on in `cap`-sized chunks.  Long output is
+ * therefore never interleaved with other writers, but it is formatted
+ * with the lock held.
+ *
+ * `lock` may be NULL if `sink` does its own locking on each write; in
+ * that case output longer than `cap` may be interleaved with other
+ * writers at chunk boundaries.
+ *
+ * A `cap` of 0 takes the fallback from the start: the lock is held
+ * for the whole call and the output is written a character at a time.
+ *
+ * \return The number of characters written to the sink
+ */
+int fmt_vsinkprintf_locked(struct fmt_sink *sink, const struct fmt_lock *lock,
+                           char *buf, size_t cap, const char *format, va_list va);
+int fmt_sinkprintf_locked(struct fmt_sink *sink, const struct fmt_lock *lock,
+                          char *buf, size_t cap, const char *format, ...);
+
+// Terminal sinks //////////////////////////////////////////////////////////////
+
+/**
+ * \brief Terminal sink that calls a per-character output function
+ */
+struct fmt_sink_fct {
+    struct fmt_sink      sink;
+    fmt_fct_t            fct;
+    void                *arg;
+};
+struct fmt_sink *fmt_sink_fct_init(struct fmt_sink_fct *s, fmt_fct_t fct, void *arg);
+
+/**
+ * \brief Terminal sink that fills a memory buffer, silently dropping
+ * anything past `maxlen`.  It does not nul-terminate the buffer.
+ */
+struct fmt_sink_buf {
+    struct fmt_sink      sink;
+    char                *buffer;
+    size_t               maxlen;
+    size_t               cur;
+};
+struct fmt_sink *fmt_sink_buf_init(struct fmt_sink_buf *s, char *buffer, size_t maxlen);
+
+// Stages //////////////////////////////////////////////////////////////////////
+
+/**
+ * \brief Copy everything to each of `n` sinks
+ */
+struct fmt_sink_tee {
+    struct fmt_sink      sink;
+    struct fmt_sink    **outs;
+    size_t               n;
+};
+struct fmt_sink *fmt_sink_tee_init(struct fmt_sink_tee *s, struct fmt_sink **outs, size_t n);
+
+/**
+ * \brief Pass bytes through unmodified, keeping a running CRC-32
+ * (IEEE 802.3; as used by zlib and Ethernet).
+ *
+ * On flush, if `append` is set then the CRC is written out as 4
+ * little-endian bytes; either way the CRC is then reset.
+ */
+struct fmt_sink_crc32 {
+    struct fmt_sink      sink;
+    struct fmt_sink     *next;
+    bool                 append;
+    uint32_t             crc;
+};
+struct fmt_sink *fmt_sink_crc32_init(struct fmt_sink_crc32 *s, struct fmt_sink *next, bool append);
+/**
+ * \brief The CRC of everything written since the last flush.
+ */
+uint32_t fmt_sink_crc32_value(const struct fmt_sink_crc32 *s);
+
+/**
+ * \brief Like fmt_sink_crc32, but CRC-16/CCITT-FALSE (polynomial
+ * 0x1021, initial value 0xFFFF), appended big-endian.
+ */
+struct fmt_sink_crc16 {
+    struct fmt_sink      sink;
+    struct fmt_sink     *next;
+    bool                 append;
+    uint16_t             crc;
+};
+struct fmt_sink *fmt_sink_crc16_init(struct fmt_sink_crc16 *s, struct fmt_sink *next, bool append);
+uint16_t fmt_sink_crc16_value(const struct fmt_sink_crc16 *s);
+
+/**
+ * \brief Consistent Overhead Byte Stuffing; each flush ends a frame
+ * with a 0x00 delimiter.
+ *
+ * Up to 254 bytes are held in the stage until a 0x00 byte, a full
+ * block, or a flush lets it emit them.
+ */
+struct fmt_sink_cobs {
+    struct fmt_sink      sink;
+    struct fmt_sink     *next;
+    bool                 full;
+    uint8_t              len;
+    char                 block[255];
+};
+struct fmt_sink *fmt_sink_cobs_init(struct fmt_sink_cobs *s, struct fmt_sink *next);
+
+/**
+ * \brief RFC 1055 Serial Line IP framing; each flush ends a frame
+ * with a 0xC0 END byte.
+ */
+struct fmt_sink_slip {
+    struct fmt_sink      sink;
+    struct fmt_sink     *next;
+};
+struct fmt_sink *fmt_sink_slip_init(struct fmt_sink_slip *s, struct fmt_sink *next);
+
+/**
+ * \brief Re-chunk the stream at line boundaries: each complete line
+ * (including its '\n') is passed on as a single write followed by a
+ * flush, so that downstream framing sees one frame per line.
+ *
+ * Lines are collected in the caller-provided `buf`; a line longer
+ * than `cap` is passed on in `cap`-sized writes, with the flush
+ * coming after its final piece.  Flushing the stage passes on (and
+ * flushes) any incomplete line.  With a `cap` of 0 nothing is
+ * collected: writes are passed straight on, still with a flush after
+ * each '\n'.
+ */
+struct fmt_sink_lines {
+    struct fmt_sink      sink;
+    struct fmt_sink     *next;
+    char                *buf;
+    size_t               cap;
+    size_t               len;
+};
+struct fmt_sink *fmt_sink_lines_init(struct fmt_sink_lines *s, struct fmt_sink *next, char *buf, size_t cap);
+
+/**
+ * \brief Pass at most `budget` bytes, dropping (and counting) the
+ * rest.
+ *
+ * Calling fmt_sink_limit_refill() from a periodic tick turns this in
+ * to a rate limiter.
+ */
+struct fmt_sink_limit {
+    struct fmt_sink      sink;
+    struct fmt_sink     *next;
+    size_t               budget;
+    size_t               dropped;
+};
+struct fmt_sink *fmt_sink_limit_init(struct fmt_sink_limit *s, struct fmt_sink *next, size_t budget);
+void fmt_sink_limit_refill(struct fmt_sink_limit *s, size_t budget);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _PICO_FMT_SINK_H
@@ -0,0 +1,54 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <limits.h>  /* for CHAR_BIT */
+
+#include "pico/fmt_maxlen.h"
+#include "printf_internal.h"
+
+// how wide the argument for each length modifier is, as printf.c reads it
+static const unsigned char _maxlen_bits[] = {
+    [FMT_SIZE_CHAR]      = sizeof(char) * CHAR_BIT,
+    [FMT_SIZE_SHORT]     = sizeof(short) * CHAR_BIT,
+    [FMT_SIZE_DEFAULT]   = sizeof(int) * CHAR_BIT,
+    [FMT_SIZE_LONG]      = sizeof(long) * CHAR_BIT,
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+    [FMT_SIZE_LONG_LONG] = sizeof(long long) * CHAR_BIT,
+#else
+    [FMT_SIZE_LONG_LONG] = sizeof(long) * CHAR_BIT,
+#endif
+};
+
+size_t fmt_maxlen(const char *format) {
+    size_t total = 0U;
+    struct fmt_state state;
+    for (;;) {
+        while (*format && *format != '%') {
+            format++;
+            total++;
+        }
+        if (!*format) {
+            break;
+        }
+        format++;
+        int conv = _fmt_parse_directive(&format, &state);
+        if (conv == CONV_NONE && state.specifier == '$' && state.width && !state.flags) {
+            // "%N$"; the directive proper follows the "$"
+            conv = _fmt_parse_directive(&format, &state);
+        }
+        if (conv < 0) {
+            // like printf, stop at a directive that the format ends in the middle of
+            break;
+        }
+        if ((state.flags & (_FMT_FLAG_WIDTH_STAR | _FMT_FLAG_PREC_STAR)) || _fmt_is_installed(state.specifier)) {
+            return FMT_MAXLEN_UNBOUNDED;
+        }
+        const size_t n = FMT_MAXLEN_DIRECTIVE(state.specifier, state.flags, state.width, state.precision,
+                                              _maxlen_bits[state.size]);
+        if (n >= FMT_MAXLEN_UNBOUNDED - total) {
+            return FMT_MAXLEN_UNBOUNDED;
+        }
+        total += n;
+    }
+    return total;
+}
@@ -0,0 +1,393 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// libpicofmt.so: pico_fmt in place of libc's printf family, for use
+// with LD_PRELOAD on a Linux host; the host-side counterpart of
+// pico_printf's pico_wrap_function() wrappers.
+//
+// Only the directives that pico_fmt renders exactly as glibc does are
+// formatted here.  A call whose format has anything else in it (%p,
+// floats, '#', %n, positional arguments, wide characters, glibc's
+// extensions, ...) is passed on whole to the libc function that it
+// would otherwise have called, found with dlsym(RTLD_NEXT).
+
+#define _GNU_SOURCE
+#undef _FORTIFY_SOURCE // we define the functions that it would wrap
+
+#include <dlfcn.h>    /* for dlsym() */
+#include <stdint.h>   /* for intmax_t */
+#include <stdio.h>    /* for FILE, fwrite_unlocked(), flockfile() */
+#include <stdlib.h>   /* for abort() */
+
+#include "pico/fmt_printf.h"
+#include "pico/fmt_sink.h"
+#include "printf_internal.h"
+
+// PICO_CONFIG: PICO_FMT_PRELOAD_STDIO, Have libpicofmt.so also replace printf/fprintf/vprintf/vfprintf (and their _FORTIFY_SOURCE variants) as well as the string functions, type=bool, default=1, group=pico_fmt
+#ifndef PICO_FMT_PRELOAD_STDIO
+#define PICO_FMT_PRELOAD_STDIO 1
+#endif
+
+// PICO_CONFIG: PICO_FMT_PRELOAD_BUFFER_SIZE, Define the size of the on-stack buffer that libpicofmt.so's printf/fprintf format in to before handing the output to the FILE, min=1, default=256, group=pico_fmt
+#ifndef PICO_FMT_PRELOAD_BUFFER_SIZE
+#define PICO_FMT_PRELOAD_BUFFER_SIZE 256
+#endif
+
+#define _EXPORT __attribute__((visibility("default")))
+
+extern void __chk_fail(void) __attribute__((noreturn));
+
+// libc //////////////////////////////////////////////////////////////
+
+enum _libc_fn {
+    LIBC_VSNPRINTF,
+    LIBC_VSPRINTF,
+    LIBC_VSNPRINTF_CHK,
+    LIBC_VSPRINTF_CHK,
+#if PICO_FMT_PRELOAD_STDIO
+    LIBC_VFPRINTF,
+    LIBC_VFPRINTF_CHK,
+#endif
+    _LIBC_COUNT,
+};
+
+static const char *const _libc_names[_LIBC_COUNT] = {
+    [LIBC_VSNPRINTF] = "vsnprintf",
+    [LIBC_VSPRINTF] = "vsprintf",
+    [LIBC_VSNPRINTF_CHK] = "__vsnprintf_chk",
+    [LIBC_VSPRINTF_CHK] = "__vsprintf_chk",
+#if PICO_FMT_PRELOAD_STDIO
+    [LIBC_VFPRINTF] = "vfprintf",
+    [LIBC_VFPRINTF_CHK] = "__vfprintf_chk",
+#endif
+};
+
+static void *_libc_fns[_LIBC_COUNT];
+
+static void *_libc(enum _libc_fn fn) {
+    // Racing threads all store the same value, so a relaxed cache is
+    // enough.
+    void *ret = __atomic_load_n(&_libc_fns[fn], __ATOMIC_RELAXED);
+    if (!ret) {
+        ret = dlsym(RTLD_NEXT, _libc_names[fn]);
+        if (!ret) {
+            abort();
+        }
+        __atomic_store_n(&_libc_fns[fn], ret, __ATOMIC_RELAXED);
+    }
+    return ret;
+}
+
+#define LIBC(fn, ...) (((fn##_t) _libc(fn))(__VA_ARGS__))
+typedef int (*LIBC_VSNPRINTF_t)(char *, size_t, const char *, va_list);
+typedef int (*LIBC_VSPRINTF_t)(char *, const char *, va_list);
+typedef int (*LIBC_VSNPRINTF_CHK_t)(char *, size_t, int, size_t, const char *, va_list);
+typedef int (*LIBC_VSPRINTF_CHK_t)(char *, int, size_t, const char *, va_list);
+#if PICO_FMT_PRELOAD_STDIO
+typedef int (*LIBC_VFPRINTF_t)(FILE *, const char *, va_list);
+typedef int (*LIBC_VFPRINTF_CHK_t)(FILE *, int, const char *, va_list);
+#endif
+
+// Pre-scan //////////////////////////////////////////////////////////
+
+/**
+ * \brief Whether every directive in `format` renders the same from
+ * pico_fmt as from glibc.
+ *
+ * This walks a copy of `va` along with the format, so as to catch the
+ * arguments that change the answer: a NULL %s (glibc prints
+ * "(null)"), and a negative '*' precision.
+ */
+static bool _supported(const char *format, va_list va) {
+    va_list ap;
+    va_copy(ap, va);
+    bool ok = true;
+    while (ok && *format) {
+        if (*format++ != '%') {
+            continue;
+        }
+        if (*format == '%') {
+            format++;
+            continue;
+        }
+
+        // flags
+        bool left = false;
+        for (;; format++) {
+            if (*format == '-') {
+                left = true;
+            } else if (*format != '+' && *format != ' ' && *format != '0') {
+                break;
+            }
+        }
+
+        // width
+        if (*format == '*') {
+            format++;
+            if (va_arg(ap, int) < 0) {
+                left = true;
+            }
+        } else {
+            while (*format >= '0' && *format <= '9') {
+                format++;
+            }
+        }
+
+        // precision
+        bool prec = false;
+        if (*format == '.') {
+            format++;
+            prec = true;
+            if (*format == '*') {
+                format++;
+                if (va_arg(ap, int) < 0) { // pico_fmt takes it as 0, not as absent
+                    ok = false;
+                }
+            } else {
+                while (*format >= '0' && *format <= '9') {
+                    format++;
+                }
+            }
+        }
+
+        // length
+        char len = '\0';
+        switch (*format) {
+        case 'h':
+            len = *format++;
+            if (*format == 'h') {
+                format++;
+            }
+            break;
+        case 'l':
+            len = *format++;
+            if (*format == 'l') {
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+                len = 'q';
+                format++;
+#else
+                ok = false;
+#endif
+            }
+            break;
+#if PICO_PRINTF_SUPPORT_PTRDIFF_T
+        case 't':
+#endif
+        case 'j':
+        case 'z':
+            len = *format++;
+            break;
+        }
+
+        // specifier
+        switch (*format++) {
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            if (left && prec) {
+                ok = false;
+                break;
+            }
+            switch (len) {
+            case 'l': (void) va_arg(ap, long); break;
+            case 'q': (void) va_arg(ap, long long); break;
+            case 't': (void) va_arg(ap, ptrdiff_t); break;
+            case 'j': (void) va_arg(ap, intmax_t); break;
+            case 'z': (void) va_arg(ap, size_t); break;
+            default:  (void) va_arg(ap, int); break;
+            }
+            break;
+        case 'c':
+            ok = !len;
+            (void) va_arg(ap, int);
+            break;
+        case 's':
+            ok = !len && va_arg(ap, const char *);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+    }
+    va_end(ap);
+    return ok;
+}
+
+// output: [S]tring //////////////////////////////////////////////////
+
+_EXPORT int vsnprintf(char *buffer, size_t count, const char *format, va_list va) {
+    if (!_supported(format, va)) {
+        return LIBC(LIBC_VSNPRINTF, buffer, count, format, va);
+    }
+    return fmt_vsnprintf(buffer, count, format, va);
+}
+
+_EXPORT int snprintf(char *buffer, size_t count, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = vsnprintf(buffer, count, format, va);
+    va_end(va);
+    return ret;
+}
+
+_EXPORT int vsprintf(char *buffer, const char *format, va_list va) {
+    if (!_supported(format, va)) {
+        return LIBC(LIBC_VSPRINTF, buffer, format, va);
+    }
+    return fmt_vsnprintf(buffer, (size_t) -1, format, va);
+}
+
+_EXPORT int sprintf(char *buffer, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = vsprintf(buffer, format, va);
+    va_end(va);
+    return ret;
+}
+
+// _FORTIFY_SOURCE turns calls with a known buffer size in to these.
+// `flag` only restricts %n, which is always passed on to libc.
+
+_EXPORT int __vsnprintf_chk(char *buffer, size_t maxlen, int flag, size_t slen, const char *format, va_list va) {
+    if (maxlen > slen) {
+        __chk_fail();
+    }
+    if (!_supported(format, va)) {
+        return LIBC(LIBC_VSNPRINTF_CHK, buffer, maxlen, flag, slen, format, va);
+    }
+    return fmt_vsnprintf(buffer, maxlen, format, va);
+}
+
+_EXPORT int __snprintf_chk(char *buffer, size_t maxlen, int flag, size_t slen, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = __vsnprintf_chk(buffer, maxlen, flag, slen, format, va);
+    va_end(va);
+    return ret;
+}
+
+_EXPORT int __vsprintf_chk(char *buffer, int flag, size_t slen, const char *format, va_list va) {
+    if (slen == 0) {
+        __chk_fail();
+    }
+    if (!_supported(format, va)) {
+        return LIBC(LIBC_VSPRINTF_CHK, buffer, flag, slen, format, va);
+    }
+    const int ret = fmt_vsnprintf(buffer, slen, format, va);
+    if (ret >= 0 && (size_t) ret >= slen) {
+        __chk_fail();
+    }
+    return ret;
+}
+
+_EXPORT int __sprintf_chk(char *buffer, int flag, size_t slen, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = __vsprintf_chk(buffer, flag, slen, format, va);
+    va_end(va);
+    return ret;
+}
+
+// output: FILE //////////////////////////////////////////////////////
+//
+// The output is formatted on the stack, then written to the FILE's
+// own buffer under its lock; so it is ordered with the rest of the
+// program's stdio, and isn't torn by other threads' output.
+
+#if PICO_FMT_PRELOAD_STDIO
+
+struct _file_sink {
+    struct fmt_sink      sink;
+    FILE                *stream;
+    bool                 err;
+};
+
+static void _file_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct _file_sink *self = (struct _file_sink *) _self;
+    if (fwrite_unlocked(buf, 1, len, self->stream) != len) {
+        self->err = true;
+    }
+}
+
+static void _file_lock(void *arg) {
+    flockfile(arg);
+}
+
+static void _file_unlock(void *arg) {
+    funlockfile(arg);
+}
+
+static int _vfprintf(FILE *stream, const char *format, va_list va) {
+    char buf[PICO_FMT_PRELOAD_BUFFER_SIZE];
+    struct _file_sink sink = {
+        .sink = { .write = _file_write },
+        .stream = stream,
+        .err = false,
+    };
+    const struct fmt_lock lock = {
+        .acquire = _file_lock,
+        .release = _file_unlock,
+        .arg = stream,
+    };
+    const int ret = fmt_vsinkprintf_locked(&sink.sink, &lock, buf, sizeof(buf), format, va);
+    return sink.err ? -1 : ret;
+}
+
+_EXPORT int vfprintf(FILE *stream, const char *format, va_list va) {
+    if (!_supported(format, va)) {
+        return LIBC(LIBC_VFPRINTF, stream, format, va);
+    }
+    return _vfprintf(stream, format, va);
+}
+
+_EXPORT int fprintf(FILE *stream, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = vfprintf(stream, format, va);
+    va_end(va);
+    return ret;
+}
+
+_EXPORT int vprintf(const char *format, va_list va) {
+    return vfprintf(stdout, format, va);
+}
+
+_EXPORT int printf(const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = vfprintf(stdout, format, va);
+    va_end(va);
+    return ret;
+}
+
+_EXPORT int __vfprintf_chk(FILE *stream, int flag, const char *format, va_list va) {
+    if (!_supported(format, va)) {
+        return LIBC(LIBC_VFPRINTF_CHK, stream, flag, format, va);
+    }
+    return _vfprintf(stream, format, va);
+}
+
+_EXPORT int __fprintf_chk(FILE *stream, int flag, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = __vfprintf_chk(stream, flag, format, va);
+    va_end(va);
+    return ret;
+}
+
+_EXPORT int __vprintf_chk(int flag, const char *format, va_list va) {
+    return __vfprintf_chk(stdout, flag, format, va);
+}
+
+_EXPORT int __printf_chk(int flag, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = __vfprintf_chk(stdout, flag, format, va);
+    va_end(va);
+    return ret;
+}
+
+#endif // PICO_FMT_PRELOAD_STDIO
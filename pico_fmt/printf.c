@@ -39,684 +39,1488 @@
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>  /* for memcpy() */
 
-#include "pico/fmt_printf.h"
-#include "pico/fmt_install.h"
+#include "printf_internal.h"
 
-// PICO_CONFIG: PICO_PRINTF_NTOA_BUFFER_SIZE, Define printf ntoa buffer size, min=0, max=128, default=32, group=pico_printf
-// 'ntoa' conversion buffer size, this must be big enough to hold one converted
-// numeric number including padded zeros (dynamically created on stack)
-#ifndef PICO_PRINTF_NTOA_BUFFER_SIZE
-#define PICO_PRINTF_NTOA_BUFFER_SIZE    32U
-#endif
-
-// PICO_CONFIG: PICO_PRINTF_FTOA_BUFFER_SIZE, Define printf ftoa buffer size, min=0, max=128, default=32, group=pico_printf
-// 'ftoa' conversion buffer size, this must be big enough to hold one converted
-// float number including padded zeros (dynamically created on stack)
-#ifndef PICO_PRINTF_FTOA_BUFFER_SIZE
-#define PICO_PRINTF_FTOA_BUFFER_SIZE    32U
-#endif
-
-// PICO_CONFIG: PICO_PRINTF_SUPPORT_FLOAT, Enable floating point printing, type=bool, default=1, group=pico_printf
-// support for the floating point type (%f)
-#ifndef PICO_PRINTF_SUPPORT_FLOAT
-#define PICO_PRINTF_SUPPORT_FLOAT 1
-#endif
-
-// PICO_CONFIG: PICO_PRINTF_SUPPORT_EXPONENTIAL, Enable exponential floating point printing, type=bool, default=1, group=pico_printf
-// support for exponential floating point notation (%e/%g)
-#ifndef PICO_PRINTF_SUPPORT_EXPONENTIAL
-#define PICO_PRINTF_SUPPORT_EXPONENTIAL 1
-#endif
-
-// PICO_CONFIG: PICO_PRINTF_DEFAULT_FLOAT_PRECISION, Define default floating point precision, min=1, max=16, default=6, group=pico_printf
-#ifndef PICO_PRINTF_DEFAULT_FLOAT_PRECISION
-#define PICO_PRINTF_DEFAULT_FLOAT_PRECISION  6U
-#endif
-
-// PICO_CONFIG: PICO_PRINTF_MAX_FLOAT, Define the largest float suitable to print with %f, min=1, max=1e9, default=1e9, group=pico_printf
-#ifndef PICO_PRINTF_MAX_FLOAT
-#define PICO_PRINTF_MAX_FLOAT  1e9
-#endif
-
-// PICO_CONFIG: PICO_PRINTF_SUPPORT_LONG_LONG, Enable support for long long types (%llu or %p), type=bool, default=1, group=pico_printf
-#ifndef PICO_PRINTF_SUPPORT_LONG_LONG
-#define PICO_PRINTF_SUPPORT_LONG_LONG 1
-#endif
-
-// PICO_CONFIG: PICO_PRINTF_SUPPORT_PTRDIFF_T, Enable support for the ptrdiff_t type (%t), type=bool, default=1, group=pico_printf
-// ptrdiff_t is normally defined in <stddef.h> as long or long long type
-#ifndef PICO_PRINTF_SUPPORT_PTRDIFF_T
-#define PICO_PRINTF_SUPPORT_PTRDIFF_T 1
-#endif
-
-///////////////////////////////////////////////////////////////////////////////
-
-// import float.h for DBL_MAX
-#if PICO_PRINTF_SUPPORT_FLOAT
-
-#include <float.h>
-
-#endif
-
-///////////////////////////////////////////////////////////////////////////////
-
-struct _fmt_ctx {
-    fmt_fct_t    fct;
-    void        *arg;
-    size_t       idx;
-};
+PICO_FMT_API inline size_t fmt_conv_len(const struct fmt_state *state) {
+    return state->ctx->idx;
+}
 
-static inline void out(char character, struct _fmt_ctx *ctx) {
-    if (ctx->fct) {
-        ctx->fct(character, ctx->arg);
-    }
-    ctx->idx++;
+PICO_FMT_API inline void fmt_conv_putchar(struct fmt_state *state, char character) {
+    out(character, state->ctx);
 }
 
-inline size_t fmt_state_len(struct fmt_state state) {
+PICO_FMT_API inline size_t fmt_state_len(struct fmt_state state) {
     return state.ctx->idx;
 }
 
-inline void fmt_state_putchar(struct fmt_state state, char character) {
+PICO_FMT_API inline void fmt_state_putchar(struct fmt_state state, char character) {
     out(character, state.ctx);
 }
 
 // internal secure strlen
 // \return The length of the string (excluding the terminating 0) limited by 'maxsize'
+// (without reading str[maxsize], which needn't exist)
 static inline unsigned int _strnlen_s(const char *str, size_t maxsize) {
     const char *s;
-    for (s = str; *s && maxsize--; ++s);
+    for (s = str; maxsize-- && *s; ++s);
     return (unsigned int) (s - str);
 }
 
 
-// internal test if char is a digit (0-9)
-// \return true if char is a digit
-static inline bool _is_digit(char ch) {
-    return (ch >= '0') && (ch <= '9');
-}
-
-static inline bool _is_upper(char ch) {
-    return (ch >= 'A') && (ch <= 'Z');
-}
+// output the specified string, taking care of any space-padding
+PICO_FMT_API void _fmt_out_padded(const struct fmt_state *state, const char *str, size_t len) {
+    const size_t start_idx = state->ctx->idx;
 
-// internal ASCII string to unsigned int conversion
-static unsigned int _atoi(const char **str) {
-    unsigned int i = 0U;
-    while (_is_digit(**str)) {
-        i = i * 10U + (unsigned int) (*((*str)++) - '0');
+    // pad spaces up to given width
+    if (!(state->flags & FMT_FLAG_LEFT) && !(state->flags & FMT_FLAG_ZEROPAD) && len < state->width) {
+        _out_fill(state->ctx, ' ', state->width - len);
     }
-    return i;
-}
 
+    while (len--) {
+        out(*str++, state->ctx);
+    }
 
-// output the specified string in reverse, taking care of any zero-padding
-static void _out_rev(struct fmt_state state, const char *buf, size_t len) {
-    const size_t start_idx = state.ctx->idx;
-
-    // pad spaces up to given width
-    if (!(state.flags & FMT_FLAG_LEFT) && !(state.flags & FMT_FLAG_ZEROPAD)) {
-        for (size_t i = len; i < state.width; i++) {
-            out(' ', state.ctx);
+    // append pad spaces up to given width
+    if (state->flags & FMT_FLAG_LEFT) {
+        const size_t n = state->ctx->idx - start_idx;
+        if (n < state->width) {
+            _out_fill(state->ctx, ' ', state->width - n);
         }
     }
+}
+
 
-    // reverse string
-    while (len) {
-        out(buf[--len], state.ctx);
+#if PICO_PRINTF_OPTIMIZE_SPEED
+// _fmt_out_dec() for a `value` < 10000; in groups of 4 so that every
+// division is by a constant
+static inline void _out_dec4(struct _fmt_ctx *ctx, unsigned int value, unsigned int place) {
+    const unsigned int hi = 2U * (value / 100U);
+    const unsigned int lo = 2U * (value % 100U);
+    if (place >= 1000U) {
+        out(_FMT_DIGIT_PAIRS[hi], ctx);
     }
+    if (place >= 100U) {
+        out(_FMT_DIGIT_PAIRS[hi + 1U], ctx);
+    }
+    if (place >= 10U) {
+        out(_FMT_DIGIT_PAIRS[lo], ctx);
+    }
+    out(_FMT_DIGIT_PAIRS[lo + 1U], ctx);
+}
+#endif
 
-    // append pad spaces up to given width
-    if (state.flags & FMT_FLAG_LEFT) {
-        while (state.ctx->idx - start_idx < state.width) {
-            out(' ', state.ctx);
-        }
+PICO_FMT_API void _fmt_out_dec(struct _fmt_ctx *ctx, unsigned int value, unsigned int place) {
+#if PICO_PRINTF_OPTIMIZE_SPEED
+    if (place >= 100000000U) {
+        _out_dec4(ctx, value / 100000000U, place / 100000000U);
+        value %= 100000000U;
+        place = 10000000U;
     }
+    if (place >= 10000U) {
+        _out_dec4(ctx, value / 10000U, place / 10000U);
+        value %= 10000U;
+        place = 1000U;
+    }
+    _out_dec4(ctx, value, place);
+#else
+    for (; place; place /= 10U) {
+        const unsigned int digit = value / place;
+        value -= digit * place;
+        out((char) ('0' + digit), ctx);
+    }
+#endif
 }
 
 
-// internal itoa format
-static void _ntoa_format(struct fmt_state state, char *buf, size_t len, bool negative, unsigned int base) {
+PICO_FMT_API size_t _fmt_ntoa_format(struct fmt_state *state, size_t len, bool negative, unsigned int base) {
     // ignore '0' flag when precision is given
-    if (state.flags & FMT_FLAG_PRECISION) {
-        state.flags &= ~FMT_FLAG_ZEROPAD;
+    if (state->flags & FMT_FLAG_PRECISION) {
+        state->flags &= ~FMT_FLAG_ZEROPAD;
+    }
+
+    char sign = '\0';
+    if (negative) {
+        sign = '-';
+    } else if (state->flags & FMT_FLAG_PLUS) {
+        sign = '+';  // ignore the space if the '+' exists
+    } else if (state->flags & FMT_FLAG_SPACE) {
+        sign = ' ';
     }
 
     // pad leading zeros
-    if (!(state.flags & FMT_FLAG_LEFT)) {
-        if (state.width && (state.flags & FMT_FLAG_ZEROPAD) && (negative || (state.flags & (FMT_FLAG_PLUS | FMT_FLAG_SPACE)))) {
-            state.width--;
+    size_t zeros = 0U;
+    if (!(state->flags & FMT_FLAG_LEFT)) {
+        if (state->width && (state->flags & FMT_FLAG_ZEROPAD) && sign) {
+            state->width--;
         }
-        while ((len < state.precision) && (len < PICO_PRINTF_NTOA_BUFFER_SIZE)) {
-            buf[len++] = '0';
+        if (len < state->precision) {
+            zeros = state->precision - len;
         }
-        while ((state.flags & FMT_FLAG_ZEROPAD) && (len < state.width) && (len < PICO_PRINTF_NTOA_BUFFER_SIZE)) {
-            buf[len++] = '0';
+        if ((state->flags & FMT_FLAG_ZEROPAD) && (len + zeros < state->width)) {
+            zeros = state->width - len;
         }
     }
 
     // handle hash
-    if (state.flags & FMT_FLAG_HASH && base != 10) {
-        if (!(state.flags & FMT_FLAG_PRECISION) && len && ((len == state.precision) || (len == state.width))) {
-            len--;
-            if (len && (base == 16U)) {
-                len--;
+    size_t skip = 0U;
+    char prefix = '\0';
+    size_t total = len + zeros;
+    if (state->flags & FMT_FLAG_HASH && base != 10) {
+        if (!(state->flags & FMT_FLAG_PRECISION) && total && ((total == state->precision) || (total == state->width))) {
+            // make room for the prefix, at the expense of the zeros
+            // and then of the digits
+            const size_t drop = (total > 1U && base == 16U) ? 2U : 1U;
+            total -= drop;
+            if (drop <= zeros) {
+                zeros -= drop;
+            } else {
+                skip = drop - zeros;
+                zeros = 0U;
             }
         }
-        if ((base == 16U) && (len < PICO_PRINTF_NTOA_BUFFER_SIZE)) {
-            buf[len++] = state.specifier;
-        } else if ((base == 2U) && (len < PICO_PRINTF_NTOA_BUFFER_SIZE)) {
-            buf[len++] = 'b';
-        }
-        if (len < PICO_PRINTF_NTOA_BUFFER_SIZE) {
-            buf[len++] = '0';
-        }
+        prefix = base == 16U ? state->specifier : (base == 2U ? 'b' : '0');
+        total += prefix == '0' ? 1U : 2U;
+    }
+    if (sign) {
+        total++;
     }
 
-    if (len < PICO_PRINTF_NTOA_BUFFER_SIZE) {
-        if (negative) {
-            buf[len++] = '-';
-        } else if (state.flags & FMT_FLAG_PLUS) {
-            buf[len++] = '+';  // ignore the space if the '+' exists
-        } else if (state.flags & FMT_FLAG_SPACE) {
-            buf[len++] = ' ';
+    // pad spaces up to given width
+    if (!(state->flags & FMT_FLAG_LEFT) && !(state->flags & FMT_FLAG_ZEROPAD) && total < state->width) {
+        _out_fill(state->ctx, ' ', state->width - total);
+    }
+    if (sign) {
+        out(sign, state->ctx);
+    }
+    if (prefix) {
+        out('0', state->ctx);
+        if (prefix != '0') {
+            out(prefix, state->ctx);
         }
     }
+    _out_fill(state->ctx, '0', zeros);
 
-    _out_rev(state, buf, len);
+    // leave the width as the spaces to append after the digits
+    state->width = ((state->flags & FMT_FLAG_LEFT) && total < state->width) ? state->width - total : 0U;
+    return skip;
 }
 
 
-// internal itoa for 'long' type
-static void _ntoa_long(struct fmt_state state, unsigned long value, bool negative, unsigned long base) {
-    char buf[PICO_PRINTF_NTOA_BUFFER_SIZE];
-    size_t len = 0U;
+// The itoa functions count the digits first, then output the number
+// (by way of _fmt_ntoa_format) most-significant digit first; `place`
+// is the place value of the next digit.
 
+#if PICO_PRINTF_OPTIMIZE_SPEED
+// _fmt_out_dec() for the `len` digits of a number that may be too big
+// for it; 9 digits at a time
+static void _out_dec_wide(struct _fmt_ctx *ctx, unsigned long long value, unsigned long long place, size_t len) {
+    if (len > 9U) {
+        _out_dec_wide(ctx, value / 1000000000U, place / 1000000000U, len - 9U);
+        value %= 1000000000U;
+        place = 100000000U;
+    }
+    _fmt_out_dec(ctx, (unsigned int) value, (unsigned int) place);
+}
+#else
+static inline char _ntoa_digit(unsigned int digit, bool upper) {
+    return (char) (digit < 10U ? '0' + digit : (upper ? 'A' : 'a') + digit - 10U);
+}
+#endif
+
+
+// internal itoa for 'long' type
+PICO_FMT_API void _fmt_ntoa_long(struct fmt_state *state, unsigned long value, bool negative, unsigned long base) {
     // no hash for 0 values
     if (!value) {
-        state.flags &= ~FMT_FLAG_HASH;
+        state->flags &= ~FMT_FLAG_HASH;
     }
 
     // write if precision != 0 and value is != 0
-    if (!(state.flags & FMT_FLAG_PRECISION) || value) {
-        do {
-            const char digit = (char) (value % base);
-            buf[len++] = (char)(digit < 10 ? '0' + digit : (_is_upper(state.specifier) ? 'A' : 'a') + digit - 10);
-            value /= base;
-        } while (value && (len < PICO_PRINTF_NTOA_BUFFER_SIZE));
+    size_t len = 0U;
+    unsigned long place = 0U;
+    if (!(state->flags & FMT_FLAG_PRECISION) || value) {
+        const unsigned long top = value / base;
+        for (len = 1U, place = 1U; place <= top; len++) {
+            place *= base;
+        }
     }
 
-    _ntoa_format(state, buf, len, negative, (unsigned int) base);
+    size_t skip = _fmt_ntoa_format(state, len, negative, (unsigned int) base);
+#if PICO_PRINTF_OPTIMIZE_SPEED
+    if (base == 10U) {
+        if (sizeof(value) > sizeof(unsigned int) && value > UINT_MAX) {
+            _out_dec_wide(state->ctx, value, place, len);
+        } else if (len) {
+            _fmt_out_dec(state->ctx, (unsigned int) value, (unsigned int) place);
+        }
+    } else if (len) {
+        const char *digits = _FMT_DIGITS(_is_upper(state->specifier));
+        const unsigned int bits = base == 16U ? 4U : (base == 8U ? 3U : 1U);
+        for (unsigned int shift = (unsigned int) (len - 1U) * bits; ; shift -= bits) {
+            if (skip) {
+                skip--;
+            } else {
+                out(digits[(value >> shift) & (base - 1U)], state->ctx);
+            }
+            if (!shift) {
+                break;
+            }
+        }
+    }
+#else
+    for (; place; place /= base) {
+        const unsigned long digit = value / place;
+        value -= digit * place;
+        if (skip) {
+            skip--;
+        } else {
+            out(_ntoa_digit((unsigned int) digit, _is_upper(state->specifier)), state->ctx);
+        }
+    }
+#endif
+    _out_fill(state->ctx, ' ', state->width);
 }
 
 
 // internal itoa for 'long long' type
 #if PICO_PRINTF_SUPPORT_LONG_LONG
 
-static void _ntoa_long_long(struct fmt_state state, unsigned long long value, bool negative, unsigned long long base) {
-    char buf[PICO_PRINTF_NTOA_BUFFER_SIZE];
-    size_t len = 0U;
-
+static void _ntoa_long_long(struct fmt_state *state, unsigned long long value, bool negative, unsigned long long base) {
     // no hash for 0 values
     if (!value) {
-        state.flags &= ~FMT_FLAG_HASH;
+        state->flags &= ~FMT_FLAG_HASH;
     }
 
     // write if precision != 0 and value is != 0
-    if (!(state.flags & FMT_FLAG_PRECISION) || value) {
-        do {
-            const char digit = (char) (value % base);
-            buf[len++] = (char)(digit < 10 ? '0' + digit : (_is_upper(state.specifier) ? 'A' : 'a') + digit - 10);
-            value /= base;
-        } while (value && (len < PICO_PRINTF_NTOA_BUFFER_SIZE));
+    size_t len = 0U;
+    unsigned long long place = 0U;
+    if (!(state->flags & FMT_FLAG_PRECISION) || value) {
+        const unsigned long long top = value / base;
+        for (len = 1U, place = 1U; place <= top; len++) {
+            place *= base;
+        }
     }
 
-    _ntoa_format(state, buf, len, negative, (unsigned int) base);
+    size_t skip = _fmt_ntoa_format(state, len, negative, (unsigned int) base);
+#if PICO_PRINTF_OPTIMIZE_SPEED
+    if (base == 10U) {
+        if (len) {
+            _out_dec_wide(state->ctx, value, place, len);
+        }
+    } else if (len) {
+        const char *digits = _FMT_DIGITS(_is_upper(state->specifier));
+        const unsigned int bits = base == 16U ? 4U : (base == 8U ? 3U : 1U);
+        for (unsigned int shift = (unsigned int) (len - 1U) * bits; ; shift -= bits) {
+            if (skip) {
+                skip--;
+            } else {
+                out(digits[(value >> shift) & (base - 1U)], state->ctx);
+            }
+            if (!shift) {
+                break;
+            }
+        }
+    }
+#else
+    for (; place; place /= base) {
+        const unsigned long long digit = value / place;
+        value -= digit * place;
+        if (skip) {
+            skip--;
+        } else {
+            out(_ntoa_digit((unsigned int) digit, _is_upper(state->specifier)), state->ctx);
+        }
+    }
+#endif
+    _out_fill(state->ctx, ' ', state->width);
 }
 
 #endif  // PICO_PRINTF_SUPPORT_LONG_LONG
 
 
-#if PICO_PRINTF_SUPPORT_FLOAT
 
-#define is_nan __builtin_isnan
+static void conv_sint(struct fmt_state *state);
+static void conv_uint(struct fmt_state *state);
+static void conv_char(struct fmt_state *state);
+static void conv_str(struct fmt_state *state);
+static void _conv_str(struct fmt_state *state, const char *p);
+static void conv_ptr(struct fmt_state *state);
+static void conv_pct(struct fmt_state *state);
 
-static bool _float_special(struct fmt_state state, double value) {
-    // test for special values
-    if (is_nan(value)) {
-        _out_rev(state, "nan", 3);
-        return true;
-    }
-    if (value < -DBL_MAX) {
-        _out_rev(state, "fni-", 4);
-        return true;
+// Parsing /////////////////////////////////////////////////////////////////////
+//
+// The directive parser is a small state machine.  Each character is
+// looked up once in _fmt_cclass, which gives both its class and a
+// value that depends on the class; the parser's state and the
+// character's class then pick an action out of _fmt_action.
+
+enum _fmt_class {
+    C_SPEC,  // anything else; value: enum _fmt_conv
+    C_FLAG,  // "-+ #"; value: FMT_FLAG_*
+    C_ZERO,  // "0", a flag or a digit depending on the state; value: FMT_FLAG_ZEROPAD
+    C_DIGIT, // "1"-"9" (C_ZERO|1, see CC_IS_DIGIT)
+    C_STAR,  // "*"
+    C_DOT,   // "."
+    C_LEN,   // "lhjzt"; value: enum fmt_size
+    C_END,   // "\0"
+    _C_COUNT,
+};
+
+#define CC(class, value) ((uint8_t) ((class) | ((value) << 3)))
+#define CC_CLASS(cc) ((cc) & 0x7U)
+#define CC_VALUE(cc) ((unsigned int) (cc) >> 3)
+#define CC_IS_DIGIT(cc) (((cc) & 0x6U) == C_ZERO)
+
+static const uint8_t _fmt_cclass[0x100] = {
+    ['\0'] = CC(C_END, 0),
+
+    ['-'] = CC(C_FLAG, FMT_FLAG_LEFT),
+    ['+'] = CC(C_FLAG, FMT_FLAG_PLUS),
+    [' '] = CC(C_FLAG, FMT_FLAG_SPACE),
+    ['#'] = CC(C_FLAG, FMT_FLAG_HASH),
+
+    ['0'] = CC(C_ZERO, FMT_FLAG_ZEROPAD),
+    ['1'] = CC(C_DIGIT, 0),
+    ['2'] = CC(C_DIGIT, 0),
+    ['3'] = CC(C_DIGIT, 0),
+    ['4'] = CC(C_DIGIT, 0),
+    ['5'] = CC(C_DIGIT, 0),
+    ['6'] = CC(C_DIGIT, 0),
+    ['7'] = CC(C_DIGIT, 0),
+    ['8'] = CC(C_DIGIT, 0),
+    ['9'] = CC(C_DIGIT, 0),
+
+    ['*'] = CC(C_STAR, 0),
+    ['.'] = CC(C_DOT, 0),
+
+    ['l'] = CC(C_LEN, FMT_SIZE_LONG),
+    ['h'] = CC(C_LEN, FMT_SIZE_SHORT),
+#if PICO_PRINTF_SUPPORT_PTRDIFF_T
+    ['t'] = CC(C_LEN, sizeof(ptrdiff_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG),
+#endif
+    ['j'] = CC(C_LEN, sizeof(intmax_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG),
+    ['z'] = CC(C_LEN, sizeof(size_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG),
+
+    ['d'] = CC(C_SPEC, CONV_SINT),
+    ['i'] = CC(C_SPEC, CONV_SINT),
+
+    ['u'] = CC(C_SPEC, CONV_UINT),
+    ['x'] = CC(C_SPEC, CONV_UINT),
+    ['X'] = CC(C_SPEC, CONV_UINT),
+    ['o'] = CC(C_SPEC, CONV_UINT),
+    ['b'] = CC(C_SPEC, CONV_UINT),
+
+    ['f'] = CC(C_SPEC, CONV_DOUBLE),
+    ['F'] = CC(C_SPEC, CONV_DOUBLE),
+    ['e'] = CC(C_SPEC, CONV_DOUBLE),
+    ['E'] = CC(C_SPEC, CONV_DOUBLE),
+    ['g'] = CC(C_SPEC, CONV_DOUBLE),
+    ['G'] = CC(C_SPEC, CONV_DOUBLE),
+
+    ['c'] = CC(C_SPEC, CONV_CHAR),
+    ['s'] = CC(C_SPEC, CONV_STR),
+    ['p'] = CC(C_SPEC, CONV_PTR),
+    ['%'] = CC(C_SPEC, CONV_PCT),
+    ['$'] = CC(C_SPEC, CONV_POS),
+};
+
+// %[flags][width][.precision][length]specifier
+enum _fmt_pstate {
+    S_FLAGS, // in the flags
+    S_WIDTH, // after the width
+    S_DOT,   // just after the "."
+    S_PREC,  // after the precision
+    _S_COUNT,
+};
+
+enum _fmt_action {
+    A_SPEC,       // this is the specifier (even if it's e.g. a misplaced flag)
+    A_FLAG,       // a run of flags
+    A_WIDTH,      // a run of digits
+    A_WIDTH_STAR,
+    A_DOT,
+    A_PREC,       // a run of digits
+    A_PREC_STAR,
+    A_LEN,        // the length, and then the next character is the specifier
+    A_END,        // the format string ended mid-directive
+};
+
+static const uint8_t _fmt_action[_S_COUNT][_C_COUNT] = {
+    //         C_SPEC  C_FLAG  C_ZERO  C_DIGIT  C_STAR        C_DOT   C_LEN  C_END
+    [S_FLAGS] = {A_SPEC, A_FLAG, A_FLAG, A_WIDTH, A_WIDTH_STAR, A_DOT,  A_LEN, A_END},
+    [S_WIDTH] = {A_SPEC, A_SPEC, A_SPEC, A_SPEC,  A_SPEC,       A_DOT,  A_LEN, A_END},
+    [S_DOT]   = {A_SPEC, A_SPEC, A_PREC, A_PREC,  A_PREC_STAR,  A_SPEC, A_LEN, A_END},
+    [S_PREC]  = {A_SPEC, A_SPEC, A_SPEC, A_SPEC,  A_SPEC,       A_SPEC, A_LEN, A_END},
+};
+
+// Parse the rest of a directive whose first character (after the '%')
+// isn't the specifier; cc is that character's class.  Leaves *formatp
+// pointing at the specifier, and returns its class (which is C_END if
+// the string ends first).  "*" arguments are fetched from args, or
+// flagged with _FMT_FLAG_{WIDTH,PREC}_STAR if args is NULL.
+__attribute__((always_inline)) static inline unsigned int _parse(const char **formatp, struct fmt_state *state, unsigned int cc, va_list *args) {
+    const char *format = *formatp;
+    const uint8_t *actions = _fmt_action[S_FLAGS];
+    for (;;) {
+        switch ((enum _fmt_action) actions[CC_CLASS(cc)]) {
+            case A_SPEC:
+            case A_END:
+                *formatp = format;
+                return cc;
+            // The usual order, flags then width then precision, falls
+            // through from one to the next without going back to the
+            // table for each.
+            case A_FLAG:
+                // the whole run of them
+                do {
+                    state->flags |= CC_VALUE(cc);
+                    cc = _fmt_cclass[(unsigned char) *++format];
+                } while (CC_CLASS(cc) == C_FLAG || CC_CLASS(cc) == C_ZERO);
+                if (CC_CLASS(cc) != C_DIGIT) {
+                    continue;
+                }
+                // fall through
+            case A_WIDTH:
+                do {
+                    state->width = state->width * 10U + (unsigned int) (*format - '0');
+                    cc = _fmt_cclass[(unsigned char) *++format];
+                } while (CC_IS_DIGIT(cc));
+                if (CC_CLASS(cc) == C_SPEC) {
+                    *formatp = format;
+                    return cc;
+                }
+                actions = _fmt_action[S_WIDTH];
+                if (CC_CLASS(cc) != C_DOT) {
+                    continue;
+                }
+                // fall through
+            case A_DOT:
+                state->flags |= FMT_FLAG_PRECISION;
+                actions = _fmt_action[S_DOT];
+                cc = _fmt_cclass[(unsigned char) *++format];
+                if (!CC_IS_DIGIT(cc)) {
+                    continue;
+                }
+                // fall through
+            case A_PREC:
+                do {
+                    state->precision = state->precision * 10U + (unsigned int) (*format - '0');
+                    cc = _fmt_cclass[(unsigned char) *++format];
+                } while (CC_IS_DIGIT(cc));
+                if (CC_CLASS(cc) == C_SPEC) {
+                    *formatp = format;
+                    return cc;
+                }
+                actions = _fmt_action[S_PREC];
+                continue;
+            case A_WIDTH_STAR:
+                if (args) {
+                    _fmt_set_width(state, va_arg(*args, int));
+                } else {
+                    state->flags |= _FMT_FLAG_WIDTH_STAR;
+                }
+                actions = _fmt_action[S_WIDTH];
+                break;
+            case A_PREC_STAR:
+                if (args) {
+                    _fmt_set_precision(state, va_arg(*args, int));
+                } else {
+                    state->flags |= _FMT_FLAG_PREC_STAR;
+                }
+                actions = _fmt_action[S_PREC];
+                break;
+            case A_LEN:
+                // "ll" and "hh"; whatever follows the length is the specifier
+                state->size = (enum fmt_size) CC_VALUE(cc);
+                if ((*format == 'l' || *format == 'h') && format[1] == *format) {
+                    state->size = (*format == 'l') ? FMT_SIZE_LONG_LONG : FMT_SIZE_CHAR;
+                    format++;
+                }
+                format++;
+                *formatp = format;
+                return _fmt_cclass[(unsigned char) *format];
+            default:
+                __builtin_unreachable();
+        }
+        cc = _fmt_cclass[(unsigned char) *++format];
     }
-    if (value > DBL_MAX) {
-        _out_rev(state, (state.flags & FMT_FLAG_PLUS) ? "fni+" : "fni", (state.flags & FMT_FLAG_PLUS) ? 4U : 3U);
-        return true;
+}
+
+PICO_FMT_API int _fmt_parse_directive(const char **format, struct fmt_state *state) {
+    state->flags = 0U;
+    state->width = 0U;
+    state->precision = 0U;
+    state->size = FMT_SIZE_DEFAULT;
+    unsigned int cc = _fmt_cclass[(unsigned char) **format];
+    if (CC_CLASS(cc) != C_SPEC) {
+        cc = _parse(format, state, cc, NULL);
+        if (CC_CLASS(cc) == C_END) {
+            return -1;
+        }
     }
+    state->specifier = **format;
+    (*format)++;
+    return CC_CLASS(cc) == C_SPEC && CC_VALUE(cc) != CONV_POS ? (int) CC_VALUE(cc) : CONV_NONE;
+}
+
+// Fast paths //////////////////////////////////////////////////////////////////
+//
+// Bare "%d", "%i", "%u", "%x", "%X", "%s" and "%c" (no flags, width,
+// precision or length) make up most directives in practice; these skip
+// struct fmt_state and _fmt_ntoa_format entirely.  (_fast_dec and
+// _fast_hex are in printf_internal.h, so that batch.c can share them.)
+
+// \return whether it handled the directive; if not, it didn't consume an argument
+static inline bool _fast_conv(struct _fmt_ctx *ctx, va_list *args, char specifier) {
+#if !PICO_PRINTF_OPTIMIZE_SPEED
+    // everything through the general path
+    (void) ctx;
+    (void) args;
+    (void) specifier;
     return false;
+#endif
+    switch (specifier) {
+        case 'd':
+        case 'i': {
+            const int value = va_arg(*args, int);
+            _fast_dec(ctx, value < 0 ? 0U - (unsigned int) value : (unsigned int) value, value < 0);
+            return true;
+        }
+        case 'u':
+            _fast_dec(ctx, va_arg(*args, unsigned int), false);
+            return true;
+        case 'x':
+        case 'X':
+            _fast_hex(ctx, va_arg(*args, unsigned int), specifier == 'X');
+            return true;
+        case 's':
+            for (const char *p = va_arg(*args, char *); *p; p++) {
+                out(*p, ctx);
+            }
+            return true;
+        case 'c':
+            out((char) va_arg(*args, int), ctx);
+            return true;
+        default:
+            return false;
+    }
 }
 
-// internal ftoa for fixed decimal floating point
-static void _ftoa(struct fmt_state state, double value) {
-    char buf[PICO_PRINTF_FTOA_BUFFER_SIZE];
-    size_t len = 0U;
-    double diff = 0.0;
+// Like _fast_conv(), but for an argument from an array; if it isn't of
+// a kind that suits the specifier, then this leaves it for the general
+// path to deal with.
+__attribute__((always_inline)) static inline bool _fast_arg(struct _fmt_ctx *ctx, const struct fmt_arg *a, char specifier) {
+#if !PICO_PRINTF_OPTIMIZE_SPEED
+    (void) ctx;
+    (void) a;
+    (void) specifier;
+    return false;
+#endif
+    const bool narrow = _fmt_type_is_integer(a->type) && _fmt_type_size[a->type] <= sizeof(unsigned int);
+    const unsigned int size = _fmt_type_size[a->type];
+    const bool sign = _fmt_type_is_signed(a->type);
+    switch (specifier) {
+        case 'd':
+        case 'i': {
+            if (!narrow) {
+                return false;
+            }
+            // (an unsigned int may be too big for an int, but not for this)
+            const long long value = (long long) _fmt_int_value(a->u, size, sign, true);
+            _fast_dec(ctx, (unsigned int) (value < 0 ? 0 - value : value), value < 0);
+            break;
+        }
+        case 'u':
+            if (!narrow) {
+                return false;
+            }
+            _fast_dec(ctx, (unsigned int) _fmt_int_value(a->u, size, sign, false), false);
+            break;
+        case 'x':
+        case 'X':
+            if (!narrow) {
+                return false;
+            }
+            _fast_hex(ctx, (unsigned int) _fmt_int_value(a->u, size, sign, false), specifier == 'X');
+            break;
+        case 's':
+            if (a->type != FMT_TYPE_STR) {
+                return false;
+            }
+            for (const char *p = a->s; *p; p++) {
+                out(*p, ctx);
+            }
+            break;
+        case 'c':
+            if (!_fmt_type_is_integer(a->type)) {
+                return false;
+            }
+            out((char) a->i, ctx);
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
 
-    // powers of 10
-    static const double pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+// Locales /////////////////////////////////////////////////////////////////////
+//
+// The built-in specifiers live in _fmt_cclass in flash; a locale only
+// holds what has been installed in to it: a bitmap of which characters
+// have been installed, and a short append-only array of entries.  An
+// entry's .character and .legacy never change once it is published
+// (by bumping ._n), so a reader can never pair a handler with the wrong
+// ABI; an install that changes the ABI appends a new entry, which
+// shadows the old one.  A legacy entry's fmt_specifier_t is stored in
+// .fn as a fmt_conv_t; the casts between the two go by way of
+// `void (*)(void)`, which is compatible with every function type.
+
+static struct fmt_locale default_locale;
+
+// Relaxed: this is on every directive's path, and only decides whether
+// to look further; _locale_find()'s load of ._n and _run_installed()'s
+// load of .fn are what order the entry and the handler.
+static inline bool _is_installed(const struct fmt_locale *locale, unsigned int c) {
+    return __atomic_load_n(&locale->_installed[c / 32], __ATOMIC_RELAXED) & (1U << (c % 32));
+}
 
-    // check for NaN and special values
-    if (_float_special(state, value))
-        return;
+static const struct _fmt_locale_entry *_locale_find(const struct fmt_locale *locale, char character) {
+    for (unsigned int i = __atomic_load_n(&locale->_n, __ATOMIC_ACQUIRE); i > 0; i--) {
+        if (locale->_entries[i-1].character == character) {
+            return &locale->_entries[i-1];
+        }
+    }
+    return NULL;
+}
 
-    // test for negative
-    bool negative = false;
-    if (value < 0) {
-        negative = true;
-        value = 0 - value;
+static bool _locale_install(struct fmt_locale *locale, char character, fmt_conv_t fn, bool legacy) {
+    const unsigned int c = (unsigned char) character;
+    struct _fmt_locale_entry *entry = (struct _fmt_locale_entry *) _locale_find(locale, character);
+    if (entry && entry->legacy == legacy) {
+        __atomic_store_n(&entry->fn, fn, __ATOMIC_RELEASE);
+        return true;
     }
+    const unsigned int n = locale->_n;
+    if (n == PICO_PRINTF_MAX_INSTALLED_SPECIFIERS) {
+        return false;
+    }
+    locale->_entries[n] = (struct _fmt_locale_entry){
+        .character = character,
+        .legacy = legacy,
+        .fn = fn,
+    };
+    __atomic_store_n(&locale->_n, n + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_or(&locale->_installed[c / 32], 1U << (c % 32), __ATOMIC_RELEASE);
+    return true;
+}
 
-    // set default precision, if not set explicitly
-    if (!(state.flags & FMT_FLAG_PRECISION)) {
-        state.precision = PICO_PRINTF_DEFAULT_FLOAT_PRECISION;
+PICO_FMT_API void fmt_locale_init(struct fmt_locale *locale) {
+    for (unsigned int i = 0; i < 0x100 / 32; i++) {
+        locale->_installed[i] = 0;
     }
-    // limit precision to 9, cause a prec >= 10 can lead to overflow errors
-    while ((len < PICO_PRINTF_FTOA_BUFFER_SIZE) && (state.precision > 9U)) {
-        buf[len++] = '0';
-        state.precision--;
+    locale->_n = 0;
+}
+
+PICO_FMT_API bool fmt_locale_install_conv(struct fmt_locale *locale, char character, fmt_conv_t fn) {
+    return _locale_install(locale, character, fn, false);
+}
+
+PICO_FMT_API bool fmt_locale_install(struct fmt_locale *locale, char character, fmt_specifier_t fn) {
+    return _locale_install(locale, character, (fmt_conv_t) (void (*)(void)) fn, true);
+}
+
+PICO_FMT_API bool fmt_install_conv(char character, fmt_conv_t fn) {
+    return _locale_install(&default_locale, character, fn, false);
+}
+
+PICO_FMT_API bool fmt_install(char character, fmt_specifier_t fn) {
+    return _locale_install(&default_locale, character, (fmt_conv_t) (void (*)(void)) fn, true);
+}
+
+PICO_FMT_API bool _fmt_is_installed(char character) {
+    return _is_installed(&default_locale, (unsigned char) character);
+}
+
+static void _run_installed(const struct fmt_locale *locale, struct fmt_state *state) {
+    state->ctx->locale = locale;
+    const struct _fmt_locale_entry *entry = _locale_find(locale, state->specifier);
+    const fmt_conv_t fn = __atomic_load_n(&entry->fn, __ATOMIC_ACQUIRE);
+    if (!fn) {
+        out(state->specifier, state->ctx);
+    } else if (entry->legacy) {
+        ((fmt_specifier_t) (void (*)(void)) fn)(*state);
+    } else {
+        fn(state);
     }
+}
 
-    int whole = (int) value;
-    double tmp = (value - whole) * pow10[state.precision];
-    unsigned long frac = (unsigned long) tmp;
-    diff = tmp - frac;
+// Typed arguments /////////////////////////////////////////////////////////////
+
+PICO_FMT_API bool _fmt_type_suits(enum fmt_type type, enum _fmt_conv conv) {
+    switch (conv) {
+        case CONV_SINT:
+        case CONV_UINT:
+        case CONV_CHAR:
+            return _fmt_type_is_integer(type);
+        case CONV_DOUBLE:
+            return type == FMT_TYPE_FLOAT || type == FMT_TYPE_DOUBLE;
+        case CONV_STR:
+            return type == FMT_TYPE_STR;
+        case CONV_PTR:
+            return type == FMT_TYPE_PTR || type == FMT_TYPE_STR;
+        default:
+            return false;
+    }
+}
 
-    if (diff > 0.5) {
-        ++frac;
-        // handle rollover, e.g. case 0.99 with prec 1 is 1.0
-        if (frac >= pow10[state.precision]) {
-            frac = 0;
-            ++whole;
+PICO_FMT_API struct fmt_arg fmt_conv_arg(struct fmt_state *state, enum fmt_type type) {
+    struct fmt_arg ret = { .type = type };
+    if (state->args) {
+        switch (type) {
+            case FMT_TYPE_FLOAT:
+            case FMT_TYPE_DOUBLE:
+                ret.f = va_arg(*state->args, double);
+                break;
+            case FMT_TYPE_STR:
+                ret.s = va_arg(*state->args, const char *);
+                break;
+            case FMT_TYPE_PTR:
+                ret.p = va_arg(*state->args, const void *);
+                break;
+            default: {
+                // anything narrower than an int was promoted to int
+                const unsigned int size = _fmt_type_size[type];
+                const unsigned long long v = size <= sizeof(int)  ? va_arg(*state->args, unsigned int)
+                                           : size <= sizeof(long) ? va_arg(*state->args, unsigned long)
+                                           :                        va_arg(*state->args, unsigned long long);
+                ret.u = _fmt_extend(v, size, _fmt_type_is_signed(type));
+                break;
+            }
         }
-    } else if (diff < 0.5) {
-    } else if ((frac == 0U) || (frac & 1U)) {
-        // if halfway, round up if odd OR if last digit is 0
-        ++frac;
+        return ret;
     }
 
-    if (state.precision == 0U) {
-        diff = value - (double) whole;
-        if (!((diff < 0.5) || (diff > 0.5)) && (whole & 1)) {
-            // exactly 0.5 and ODD, then round up
-            // 1.5 -> 2, but 2.5 -> 2
-            ++whole;
+    struct _fmt_ctx *ctx = state->ctx;
+    const enum _fmt_conv kind = _fmt_type_is_integer(type) ? CONV_SINT
+                              : type == FMT_TYPE_STR       ? CONV_STR
+                              : type == FMT_TYPE_PTR       ? CONV_PTR
+                              :                              CONV_DOUBLE;
+    if (!ctx->argc || !_fmt_type_suits(ctx->argv->type, kind)) {
+        ctx->bad_arg = true;
+        return ret;
+    }
+    const struct fmt_arg *next = ctx->argv++;
+    ctx->argc--;
+    ret.u = next->u;
+    if (kind == CONV_SINT) {
+        // as if the argument had been converted to `type`
+        ret.u = _fmt_extend(next->u, _fmt_type_size[type], _fmt_type_is_signed(type));
+    } else if (kind == CONV_DOUBLE) {
+        ret.f = next->f;
+    }
+    return ret;
+}
+
+// Positional arguments ////////////////////////////////////////////////////////
+//
+// POSIX "%N$" directives (and "*N$" widths and precisions) may take
+// the arguments in any order, but a va_list can only be walked
+// forward.  So once fmt_vctxprintf() sees one, the rest of the format
+// goes through _fmt_vposprintf(): it scans the format once to find the
+// type of each argument, fetches them all in to an on-stack array in
+// one walk of the va_list, and then formats, indexing in to the array.
+//
+// As in POSIX, a format may not mix positional and sequential
+// directives, and may not leave out an argument (there'd be no way to
+// know its type to step over it); nor may it use installed specifiers,
+// whose types can't be known up front.
+
+#define _POS_UNUSED 0xFFU
+
+struct _pos_directive {
+    unsigned int         arg;       // "%N$"
+    unsigned int         width_arg; // "*N$"
+    unsigned int         prec_arg;  // ".*N$"
+};
+
+// Parse a "N$" at *format.  \return N, or 0 if there isn't one (leaving
+// *format alone), or something over PICO_PRINTF_MAX_POSITIONAL_ARGS if
+// N is 0 or too big.
+static unsigned int _pos_index(const char **format) {
+    const char *p = *format;
+    unsigned int n = 0U;
+    while (*p >= '0' && *p <= '9') {
+        n = n * 10U + (unsigned int) (*p++ - '0');
+        if (n > PICO_PRINTF_MAX_POSITIONAL_ARGS) {
+            n = PICO_PRINTF_MAX_POSITIONAL_ARGS + 1U;
         }
+    }
+    if (p == *format || *p != '$') {
+        return 0U;
+    }
+    *format = p + 1;
+    return n ? n : PICO_PRINTF_MAX_POSITIONAL_ARGS + 1U;
+}
+
+// Like _fmt_parse_directive(), but for
+// %[N$][flags][width|*N$][.precision|.*N$][length]specifier; "*N$"
+// sets _FMT_FLAG_{WIDTH,PREC}_STAR.
+static int _pos_parse(const char **formatp, struct fmt_state *state, struct _pos_directive *d) {
+    const char *format = *formatp;
+    state->flags = 0U;
+    state->width = 0U;
+    state->precision = 0U;
+    state->size = FMT_SIZE_DEFAULT;
+    d->arg = _pos_index(&format);
+    d->width_arg = d->prec_arg = 0U;
+
+    unsigned int cc = _fmt_cclass[(unsigned char) *format];
+    while (CC_CLASS(cc) == C_FLAG || CC_CLASS(cc) == C_ZERO) {
+        state->flags |= CC_VALUE(cc);
+        cc = _fmt_cclass[(unsigned char) *++format];
+    }
+    if (CC_CLASS(cc) == C_STAR) {
+        format++;
+        state->flags |= _FMT_FLAG_WIDTH_STAR;
+        d->width_arg = _pos_index(&format);
+        cc = _fmt_cclass[(unsigned char) *format];
     } else {
-        unsigned int count = state.precision;
-        // now do fractional part, as an unsigned number
-        while (len < PICO_PRINTF_FTOA_BUFFER_SIZE) {
-            --count;
-            buf[len++] = (char) (48U + (frac % 10U));
-            if (!(frac /= 10U)) {
-                break;
-            }
+        for (; CC_IS_DIGIT(cc); cc = _fmt_cclass[(unsigned char) *++format]) {
+            state->width = state->width * 10U + (unsigned int) (*format - '0');
         }
-        // add extra 0s
-        while ((len < PICO_PRINTF_FTOA_BUFFER_SIZE) && (count-- > 0U)) {
-            buf[len++] = '0';
+    }
+    if (CC_CLASS(cc) == C_DOT) {
+        state->flags |= FMT_FLAG_PRECISION;
+        cc = _fmt_cclass[(unsigned char) *++format];
+        if (CC_CLASS(cc) == C_STAR) {
+            format++;
+            state->flags |= _FMT_FLAG_PREC_STAR;
+            d->prec_arg = _pos_index(&format);
+            cc = _fmt_cclass[(unsigned char) *format];
+        } else {
+            for (; CC_IS_DIGIT(cc); cc = _fmt_cclass[(unsigned char) *++format]) {
+                state->precision = state->precision * 10U + (unsigned int) (*format - '0');
+            }
         }
-        if (len < PICO_PRINTF_FTOA_BUFFER_SIZE) {
-            // add decimal
-            buf[len++] = '.';
+    }
+    if (CC_CLASS(cc) == C_LEN) {
+        state->size = (enum fmt_size) CC_VALUE(cc);
+        if ((*format == 'l' || *format == 'h') && format[1] == *format) {
+            state->size = (*format == 'l') ? FMT_SIZE_LONG_LONG : FMT_SIZE_CHAR;
+            format++;
         }
+        cc = _fmt_cclass[(unsigned char) *++format];
+    }
+
+    *formatp = format;
+    if (CC_CLASS(cc) == C_END) {
+        return -1;
+    }
+    state->specifier = *format;
+    (*formatp)++;
+    return CC_CLASS(cc) == C_SPEC && CC_VALUE(cc) != CONV_POS ? (int) CC_VALUE(cc) : CONV_NONE;
+}
+
+// \return what a directive's argument is fetched from the va_list as,
+// or -1 if it doesn't take one
+static int _pos_type(int conv, enum fmt_size size) {
+    switch (conv) {
+        case CONV_SINT:
+        case CONV_UINT:
+            return size == FMT_SIZE_LONG_LONG ? FMT_TYPE_LLONG
+                 : size == FMT_SIZE_LONG      ? FMT_TYPE_LONG
+                 :                              FMT_TYPE_INT;
+        case CONV_CHAR:
+            return FMT_TYPE_INT;
+        case CONV_DOUBLE:
+            return FMT_TYPE_DOUBLE;
+        case CONV_STR:
+            return FMT_TYPE_STR;
+        case CONV_PTR:
+            return FMT_TYPE_PTR;
+        default:
+            return -1;
+    }
+}
+
+// record that argument n is fetched as type
+static bool _pos_need(uint8_t *types, unsigned int *nargs, unsigned int n, int type) {
+    if (!n || n > PICO_PRINTF_MAX_POSITIONAL_ARGS || (types[n-1] != _POS_UNUSED && types[n-1] != type)) {
+        return false;
     }
+    types[n-1] = (uint8_t) type;
+    if (n > *nargs) {
+        *nargs = n;
+    }
+    return true;
+}
 
-    // do whole part, number is reversed
-    while (len < PICO_PRINTF_FTOA_BUFFER_SIZE) {
-        buf[len++] = (char) (48 + (whole % 10));
-        if (!(whole /= 10)) {
+static const uint8_t _pos_size[] = {
+    [FMT_SIZE_CHAR]      = sizeof(char),
+    [FMT_SIZE_SHORT]     = sizeof(short),
+    [FMT_SIZE_DEFAULT]   = sizeof(int),
+    [FMT_SIZE_LONG]      = sizeof(long),
+    [FMT_SIZE_LONG_LONG] = sizeof(long long),
+};
+
+// Whether a sequential directive (one that takes an argument) comes
+// before a positional one.  fmt_vctxprintf() only checks this once it
+// gets to the first positional directive, so that formats without any
+// don't pay for a scan; the output before that has already been sent.
+__attribute__((noinline, cold)) static bool _pos_mixed(const struct fmt_locale *locale, const char *format) {
+    struct fmt_state state;
+    struct _pos_directive d;
+    bool sequential = false;
+    for (const char *p = format; *p; ) {
+        if (*p++ != '%') {
+            continue;
+        }
+        const int conv = _pos_parse(&p, &state, &d);
+        if (conv < 0) {
             break;
         }
+        if (d.arg || d.width_arg || d.prec_arg) {
+            return sequential;
+        }
+        if (_pos_type(conv, state.size) >= 0 || (state.flags & (_FMT_FLAG_WIDTH_STAR | _FMT_FLAG_PREC_STAR)) ||
+            _is_installed(locale, (unsigned char) state.specifier)) {
+            sequential = true;
+        }
     }
+    return false;
+}
 
-    // pad leading zeros
-    if (!(state.flags & FMT_FLAG_LEFT) && (state.flags & FMT_FLAG_ZEROPAD)) {
-        if (state.width && (negative || (state.flags & (FMT_FLAG_PLUS | FMT_FLAG_SPACE)))) {
-            state.width--;
+// format points at the '%' of the first positional directive
+__attribute__((noinline, cold)) static int _fmt_vposprintf(const struct fmt_locale *locale, struct _fmt_ctx *ctx,
+                                                     const char *format, va_list *args) {
+    struct fmt_state state = {
+        .args = NULL,
+        .ctx  = ctx,
+    };
+    struct _pos_directive d;
+
+    // what is each argument?
+    uint8_t types[PICO_PRINTF_MAX_POSITIONAL_ARGS];
+    for (unsigned int i = 0; i < PICO_PRINTF_MAX_POSITIONAL_ARGS; i++) {
+        types[i] = _POS_UNUSED;
+    }
+    unsigned int nargs = 0U;
+    for (const char *p = format; *p; ) {
+        if (*p++ != '%') {
+            continue;
+        }
+        const int conv = _pos_parse(&p, &state, &d);
+        if (conv < 0) {
+            break;
         }
-        while ((len < state.width) && (len < PICO_PRINTF_FTOA_BUFFER_SIZE)) {
-            buf[len++] = '0';
+        if (_is_installed(locale, (unsigned char) state.specifier)) {
+            return -1;
+        }
+        const int type = _pos_type(conv, state.size);
+        if (((state.flags & _FMT_FLAG_WIDTH_STAR) && !_pos_need(types, &nargs, d.width_arg, FMT_TYPE_INT)) ||
+            ((state.flags & _FMT_FLAG_PREC_STAR) && !_pos_need(types, &nargs, d.prec_arg, FMT_TYPE_INT)) ||
+            (type >= 0 && !_pos_need(types, &nargs, d.arg, type))) {
+            return -1;
         }
     }
 
-    if (len < PICO_PRINTF_FTOA_BUFFER_SIZE) {
-        if (negative) {
-            buf[len++] = '-';
-        } else if (state.flags & FMT_FLAG_PLUS) {
-            buf[len++] = '+';  // ignore the space if the '+' exists
-        } else if (state.flags & FMT_FLAG_SPACE) {
-            buf[len++] = ' ';
+    // fetch them all, in order
+    struct fmt_arg argv[PICO_PRINTF_MAX_POSITIONAL_ARGS];
+    struct fmt_state fetch = {
+        .args = args,
+        .ctx  = ctx,
+    };
+    for (unsigned int i = 0; i < nargs; i++) {
+        if (types[i] == _POS_UNUSED) {
+            return -1;
         }
+        argv[i] = fmt_conv_arg(&fetch, (enum fmt_type) types[i]);
     }
 
-    _out_rev(state, buf, len);
-}
+    // and format
+    while (*format) {
+        if (*format != '%') {
+            out(*format, ctx);
+            format++;
+            continue;
+        }
+        format++;
+
+        const int conv = _pos_parse(&format, &state, &d);
+        if (conv < 0) {
+            break;
+        }
+        if (state.flags & _FMT_FLAG_WIDTH_STAR) {
+            _fmt_set_width(&state, (int) argv[d.width_arg-1].i);
+        }
+        if (state.flags & _FMT_FLAG_PREC_STAR) {
+            _fmt_set_precision(&state, (int) argv[d.prec_arg-1].i);
+        }
+        state.flags &= ~(_FMT_FLAG_WIDTH_STAR | _FMT_FLAG_PREC_STAR);
+
+        union _fmt_value v = {0};
+        if (_pos_type(conv, state.size) >= 0) {
+            const struct fmt_arg *a = &argv[d.arg-1];
+            v.u = a->u;
+            if (conv == CONV_SINT || conv == CONV_UINT) {
+                // as the sequential conversions truncate "h" and "hh"
+                v.u = _fmt_extend(a->u, _pos_size[state.size], conv == CONV_SINT);
+            } else if (conv == CONV_DOUBLE) {
+                v.f = a->f;
+            }
+        }
+        _fmt_convert(&state, (enum _fmt_conv) conv, v);
+    }
 
+    return (int) ctx->idx;
+}
 
-#if PICO_PRINTF_SUPPORT_EXPONENTIAL
+// Limits //////////////////////////////////////////////////////////////////////
+//
+// For fmt_vfctprintf_limited(); each is only called if ctx->limits.
 
-// internal ftoa variant for exponential floating-point type, contributed by Martijn Jasperse <m.jasperse@gmail.com>
-static void _etoa(struct fmt_state state, double value, bool adapt_exp) {
-    // check for NaN and special values
-    if (_float_special(state, value))
-        return;
+// \return whether to go on to the next directive
+__attribute__((noinline, cold)) static bool _limit_next(struct _fmt_ctx *ctx) {
+    if (ctx->directives == ctx->limits->max_directives || ctx->idx > ctx->limits->max_output) {
+        ctx->limited = true;
+        return false;
+    }
+    ctx->directives++;
+    return true;
+}
 
-    // determine the sign
-    const bool negative = value < 0;
-    if (negative) {
-        value = -value;
-    }
-
-    // default precision
-    if (!(state.flags & FMT_FLAG_PRECISION)) {
-        state.precision = PICO_PRINTF_DEFAULT_FLOAT_PRECISION;
-    }
-
-    // determine the decimal exponent
-    // based on the algorithm by David Gay (https://www.ampl.com/netlib/fp/dtoa.c)
-    union {
-        uint64_t U;
-        double F;
-    } conv;
-
-    conv.F = value;
-    int expval;
-    if (conv.U) {
-        int exp2 = (int) ((conv.U >> 52U) & 0x07FFU) - 1023;           // effectively log2
-        conv.U = (conv.U & ((1ULL << 52U) - 1U)) | (1023ULL << 52U);  // drop the exponent so conv.F is now in [1,2)
-        // now approximate log10 from the log2 integer part and an expansion of ln around 1.5
-        expval = (int) (0.1760912590558 + exp2 * 0.301029995663981 + (conv.F - 1.5) * 0.289529654602168);
-        // now we want to compute 10^expval but we want to be sure it won't overflow
-        exp2 = (int) (expval * 3.321928094887362 + 0.5);
-        const double z = expval * 2.302585092994046 - exp2 * 0.6931471805599453;
-        const double z2 = z * z;
-        conv.U = (uint64_t) (exp2 + 1023) << 52U;
-        // compute exp(z) using continued fractions, see https://en.wikipedia.org/wiki/Exponential_function#Continued_fractions_for_ex
-        conv.F *= 1 + 2 * z / (2 - z + (z2 / (6 + (z2 / (10 + z2 / 14)))));
-        // correct for rounding errors
-        if (value < conv.F) {
-            expval--;
-            conv.F /= 10;
+// Cut the directive down to size; a "%s" is done here and now, since
+// how much of it to read can't be left to _conv_str().
+// \return whether it did the directive
+__attribute__((noinline, cold)) static bool _limit_directive(const struct fmt_locale *locale, struct fmt_state *state,
+                                                             enum _fmt_conv conv) {
+    struct _fmt_ctx *ctx = state->ctx;
+    const struct fmt_limits *limits = ctx->limits;
+    if (state->width > limits->max_width) {
+        state->width = limits->max_width;
+        ctx->limited = true;
+    }
+    if (state->precision > limits->max_precision) {
+        state->precision = limits->max_precision;
+        ctx->limited = true;
+    }
+    if (conv != CONV_STR || _is_installed(locale, (unsigned char) state->specifier)) {
+        return false;
+    }
+    const char *p = va_arg(*state->args, char *);
+    if (!(state->flags & FMT_FLAG_PRECISION)) {
+        state->flags |= FMT_FLAG_PRECISION;
+        state->precision = limits->max_precision;
+        // whether there was more can't be known without reading past
+        // max_precision, so a string that fills it counts as cut off
+        if (_strnlen_s(p, limits->max_precision) == limits->max_precision) {
+            ctx->limited = true;
         }
-    } else {
-        expval = 0;
     }
+    _conv_str(state, p);
+    return true;
+}
 
-    // the exponent format is "%+03d" and largest value is "307", so set aside 4-5 characters
-    unsigned int minwidth = ((expval < 100) && (expval > -100)) ? 4U : 5U;
+// only ever sends the first room characters on to fct
+struct _limit_out {
+    fmt_fct_t    fct;
+    void        *arg;
+    size_t       room;
+};
 
-    // in "%g" mode, "state.precision" is the number of *significant figures* not decimals
-    if (adapt_exp) {
-        // do we want to fall-back to "%f" mode?
-        if ((conv.U == 0) || ((value >= 1e-4) && (value < 1e6))) {
-            if ((int) state.precision > expval) {
-                state.precision = (unsigned) ((int) state.precision - expval - 1);
-            } else {
-                state.precision = 0;
+static void _limit_out(char character, void *arg) {
+    struct _limit_out *o = arg;
+    if (o->room) {
+        o->room--;
+        o->fct(character, o->arg);
+    }
+}
+
+// Formatting //////////////////////////////////////////////////////////////////
+
+// fmt_vctxprintf(), to an already set-up ctx and a copy of the va_list;
+// limited is a constant, so that only fmt_vfctprintf_limited()'s copy
+// of this pays for the limits
+__attribute__((always_inline)) static inline int _vctxprintf_body(const struct fmt_locale *locale, struct _fmt_ctx *ctx,
+                                                                  const char *format, va_list *args, const bool limited) {
+    if (!locale) {
+        locale = &default_locale;
+    }
+    struct fmt_state state = {
+        .args = args,
+        .ctx  = ctx,
+    };
+    const char *const start = format;
+
+    while (*format) {
+        // format specifier?  %[flags][width][.precision][length]specifier
+        if (*format != '%') {
+            // no
+#if PICO_PRINTF_BUFFER_SINK && PICO_PRINTF_OPTIMIZE_SPEED
+            if (!ctx->fct) {
+                // the whole run of literal text at once
+                char *buffer = ctx->buffer;
+                const size_t maxlen = ctx->maxlen;
+                size_t idx = ctx->idx;
+                do {
+                    if (idx < maxlen) {
+                        buffer[idx] = *format;
+                    }
+                    idx++;
+                    format++;
+                } while (*format && *format != '%');
+                ctx->idx = idx;
+                continue;
             }
-            state.flags |= FMT_FLAG_PRECISION;   // make sure _ftoa respects precision
-            // no characters in exponent
-            minwidth = 0U;
-            expval = 0;
+#endif
+            out(*format, ctx);
+            format++;
+            continue;
         } else {
-            // we use one sigfig for the whole part
-            if ((state.precision > 0) && (state.flags & FMT_FLAG_PRECISION)) {
-                --state.precision;
+            // yes, evaluate it
+            format++;
+        }
+
+        unsigned int cc = _fmt_cclass[(unsigned char) *format];
+        if (limited) {
+            // (and no fast paths, which don't know about the limits)
+            if (!_limit_next(ctx)) {
+                break;
+            }
+        } else if (CC_CLASS(cc) == C_SPEC) {
+            // the common case
+            if (!_is_installed(locale, (unsigned char) *format) && _fast_conv(ctx, args, *format)) {
+                format++;
+                continue;
+            }
+        }
+        state.flags = 0U;
+        state.width = 0U;
+        state.precision = 0U;
+        state.size = FMT_SIZE_DEFAULT;
+        if (CC_CLASS(cc) != C_SPEC) {
+            const char *rest = format;
+            cc = _parse(&rest, &state, cc, args);
+            format = rest;
+            if (CC_CLASS(cc) == C_END) {
+                break;
             }
         }
-    }
 
-    // will everything fit?
-    unsigned int fwidth = state.width;
-    if (fwidth > minwidth) {
-        // we didn't fall-back so subtract the characters required for the exponent
-        fwidth -= minwidth;
-    } else {
-        // not enough characters, so go back to default sizing
-        fwidth = 0U;
+        // evaluate specifier
+        state.specifier = *format;
+        format++;
+        const enum _fmt_conv conv = CC_CLASS(cc) == C_SPEC ? (enum _fmt_conv) CC_VALUE(cc) : CONV_NONE;
+        if (limited && _limit_directive(locale, &state, conv)) {
+            continue;
+        }
+        if (__builtin_expect(_is_installed(locale, (unsigned char) state.specifier), 0)) {
+            _run_installed(locale, &state);
+            continue;
+        }
+        switch (conv) {
+            case CONV_SINT:   conv_sint(&state);        break;
+            case CONV_UINT:   conv_uint(&state);        break;
+            case CONV_DOUBLE: _fmt_dtoa(&state, va_arg(*state.args, double)); break;
+            case CONV_CHAR:   conv_char(&state);        break;
+            case CONV_STR:    conv_str(&state);         break;
+            case CONV_PTR:    conv_ptr(&state);         break;
+            case CONV_PCT:    conv_pct(&state);         break;
+            case CONV_POS:
+                if (__builtin_expect(state.width && !state.flags && state.size == FMT_SIZE_DEFAULT, 0)) {
+                    // "%N$"; the rest of the format is positional.  (Only
+                    // digits come between the '%' and the '$'.)
+                    if (limited || _pos_mixed(locale, start)) {
+                        return -1;
+                    }
+                    const char *directive = format - 1;
+                    while (*--directive != '%') {}
+                    return _fmt_vposprintf(locale, ctx, directive, args);
+                }
+                // fall through
+            case CONV_NONE:   out(state.specifier, ctx); break;
+        }
     }
-    if ((state.flags & FMT_FLAG_LEFT) && minwidth) {
-        // if we're padding on the right, DON'T pad the floating part
-        fwidth = 0U;
+
+    return (int) ctx->idx;
+}
+
+static int _vctxprintf(const struct fmt_locale *locale, struct _fmt_ctx *ctx, const char *format, va_list *args) {
+    return _vctxprintf_body(locale, ctx, format, args, false);
+}
+
+PICO_FMT_API int fmt_vfctprintf_limited(const struct fmt_limits *limits, fmt_fct_t fct, void *arg,
+                                        const char *format, va_list va) {
+    struct _limit_out o = {
+        .fct = fct,
+        .arg = arg,
+        .room = limits->max_output,
+    };
+    struct _fmt_ctx ctx = {
+        .fct = fct ? _limit_out : NULL,
+        .arg = &o,
+        .idx = 0,
+        .limits = limits,
+    };
+    va_list args;
+    va_copy(args, va);
+    const int ret = _vctxprintf_body(NULL, &ctx, format, &args, true);
+    va_end(args);
+    return ret < 0 ? ret : ctx.limited || ctx.idx > limits->max_output ? FMT_LIMITED : ret;
+}
+
+PICO_FMT_API int fmt_vfctprintf(fmt_fct_t fct, void *arg, const char *format, va_list va) {
+    return fmt_vctxprintf(NULL, fct, arg, format, va);
+}
+
+PICO_FMT_API int fmt_vctxprintf(const struct fmt_locale *locale, fmt_fct_t fct, void *arg, const char *format, va_list va) {
+    struct _fmt_ctx ctx = {
+        .fct = fct,
+        .arg = arg,
+        .idx = 0,
+    };
+    va_list args;
+    va_copy(args, va);
+    const int ret = _vctxprintf(locale, &ctx, format, &args);
+    va_end(args);
+    return ret;
+}
+
+#if PICO_PRINTF_BUFFER_SINK
+// (otherwise it's in convenience.c, on top of fmt_vfctprintf())
+PICO_FMT_API int fmt_vsnprintf(char *buffer, size_t count, const char *format, va_list va) {
+    // straight in to the buffer, rather than through an output function
+    struct _fmt_ctx ctx = {
+        .idx = 0,
+        .buffer = buffer,
+        .maxlen = buffer ? count : 0U,
+    };
+    va_list args;
+    va_copy(args, va);
+    const int ret = _vctxprintf(NULL, &ctx, format, &args);
+    va_end(args);
+    if (buffer && count)
+        buffer[ctx.idx < count ? ctx.idx : count-1] = '\0'; // nul-terminate
+    return ret;
+}
+#endif
+
+// Nested formatting //////////////////////////////////////////////////////////
+
+// \return as fmt_vctxprintf() would, were ctx's output all its own
+static int _vctxprintf_nested(struct _fmt_ctx *ctx, const char *format, va_list va) {
+    va_list args;
+    va_copy(args, va);
+    const int ret = _vctxprintf(ctx->locale, ctx, format, &args);
+    va_end(args);
+    return ret;
+}
+
+PICO_FMT_API int fmt_conv_vprintf(struct fmt_state *state, const char *format, va_list va) {
+    struct _fmt_ctx *parent = state->ctx;
+    const size_t start_idx = parent->idx;
+
+    // the same output and running count, but arguments of its own
+    struct _fmt_ctx ctx = *parent;
+    ctx.argv = NULL;
+    ctx.argc = 0U;
+
+    if (!(state->flags & FMT_FLAG_LEFT) && state->width) {
+        // a dry run, that outputs nothing, to see how much to pad
+        struct _fmt_ctx dry = ctx;
+        dry.fct = NULL;
+#if PICO_PRINTF_BUFFER_SINK
+        dry.maxlen = 0U;
+#endif
+        if (_vctxprintf_nested(&dry, format, va) < 0) {
+            return -1;
+        }
+        const size_t len = dry.idx - start_idx;
+        if (len < state->width) {
+            _out_fill(&ctx, ' ', state->width - len);
+        }
     }
 
-    // rescale the float value
-    if (expval) {
-        value /= conv.F;
+    const int ret = _vctxprintf_nested(&ctx, format, va);
+
+    if (ret >= 0 && (state->flags & FMT_FLAG_LEFT)) {
+        const size_t n = ctx.idx - start_idx;
+        if (n < state->width) {
+            _out_fill(&ctx, ' ', state->width - n);
+        }
     }
+    parent->idx = ctx.idx;
+    parent->bad_arg |= ctx.bad_arg;
+    return ret < 0 ? -1 : (int) (ctx.idx - start_idx);
+}
 
-    // output the floating part
-    const size_t start_idx = state.ctx->idx;
-    struct fmt_state substate = {
-        .width = fwidth,
-        .precision = state.precision,
-        .flags = state.flags,
-        .specifier = 'f',
-        .ctx = state.ctx,
-    };
-    _ftoa(substate, negative ? -value : value);
-
-    // output the exponent part
-    if (minwidth) {
-        // output the exponential symbol
-        out(_is_upper(state.specifier) ? 'E' : 'e', state.ctx);
-        // output the exponent value
-        struct fmt_state substate = {
-            .width = minwidth - 1,
-            .precision = 0,
-            .flags = FMT_FLAG_ZEROPAD | FMT_FLAG_PLUS,
-            .specifier = 'u',
-            .ctx = state.ctx,
-        };
-        _ntoa_long(substate, (unsigned int)((expval < 0) ? -expval : expval), expval < 0, 10);
-        // might need to right-pad spaces
-        if (state.flags & FMT_FLAG_LEFT) {
-            while (state.ctx->idx - start_idx < state.width) out(' ', state.ctx);
-        }
-    }
-}
-
-#endif  // PICO_PRINTF_SUPPORT_EXPONENTIAL
-#endif  // PICO_PRINTF_SUPPORT_FLOAT
-
-static void conv_sint(struct fmt_state state);
-static void conv_uint(struct fmt_state state);
-static void conv_double(struct fmt_state state);
-static void conv_char(struct fmt_state state);
-static void conv_str(struct fmt_state state);
-static void conv_ptr(struct fmt_state state);
-static void conv_pct(struct fmt_state state);
-
-static fmt_specifier_t specifier_table[0x100] = {
-    ['d'] = conv_sint,
-    ['i'] = conv_sint,
-
-    ['u'] = conv_uint,
-    ['x'] = conv_uint,
-    ['X'] = conv_uint,
-    ['o'] = conv_uint,
-    ['b'] = conv_uint,
-
-    ['f'] = conv_double,
-    ['F'] = conv_double,
-    ['e'] = conv_double,
-    ['E'] = conv_double,
-    ['g'] = conv_double,
-    ['G'] = conv_double,
-
-    ['c'] = conv_char,
-    ['s'] = conv_str,
-    ['p'] = conv_ptr,
-    ['%'] = conv_pct,
-};
+PICO_FMT_API int fmt_conv_printf(struct fmt_state *state, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_conv_vprintf(state, format, va);
+    va_end(va);
+    return ret;
+}
 
-void fmt_install(char character, fmt_specifier_t fn) {
-    specifier_table[(unsigned int)character] = fn;
+PICO_FMT_API void _fmt_convert_arg(struct fmt_state *state, enum _fmt_conv conv, const struct fmt_arg *a) {
+    union _fmt_value v;
+    switch (conv) {
+        case CONV_SINT:
+        case CONV_UINT:
+            // as printf would if given the argument's type
+            v.u = _fmt_int_value(a->u, _fmt_type_size[a->type], _fmt_type_is_signed(a->type), conv == CONV_SINT);
+            break;
+        case CONV_DOUBLE:
+            v.f = a->f;
+            break;
+        default:
+            v.u = a->u;
+            break;
+    }
+    _fmt_convert(state, conv, v);
 }
 
-int fmt_vfctprintf(fmt_fct_t fct, void *arg, const char *format, va_list _va) {
-    unsigned int n;
+PICO_FMT_API int fmt_fctprintf_args(fmt_fct_t fct, void *arg, const char *format, const struct fmt_arg *args, size_t n) {
+    return fmt_ctxprintf_args(NULL, fct, arg, format, args, n);
+}
+
+PICO_FMT_API int fmt_ctxprintf_args(const struct fmt_locale *locale, fmt_fct_t fct, void *arg, const char *format,
+                       const struct fmt_arg *args, size_t n) {
+    if (!locale) {
+        locale = &default_locale;
+    }
     struct _fmt_ctx _ctx = {
         .fct = fct,
         .arg = arg,
         .idx = 0,
+        .argv = args,
+        .argc = n,
     };
-    va_list _va_save;
-    va_copy(_va_save, _va);
     struct fmt_state state = {
-        .args = &_va_save,
+        .args = NULL,
         .ctx  = &_ctx,
     };
 
     while (*format) {
-        // format specifier?  %[flags][width][.precision][length]specifier
         if (*format != '%') {
-            // no
-            out(*format, state.ctx);
+            out(*format, &_ctx);
             format++;
             continue;
-        } else {
-            // yes, evaluate it
-            format++;
         }
+        format++;
 
-        // evaluate flags
-        state.flags = 0U;
-        do {
-            switch (*format) {
-                case '0':
-                    state.flags |= FMT_FLAG_ZEROPAD;
-                    format++;
-                    n = 1U;
-                    break;
-                case '-':
-                    state.flags |= FMT_FLAG_LEFT;
-                    format++;
-                    n = 1U;
-                    break;
-                case '+':
-                    state.flags |= FMT_FLAG_PLUS;
-                    format++;
-                    n = 1U;
-                    break;
-                case ' ':
-                    state.flags |= FMT_FLAG_SPACE;
-                    format++;
-                    n = 1U;
-                    break;
-                case '#':
-                    state.flags |= FMT_FLAG_HASH;
-                    format++;
-                    n = 1U;
-                    break;
-                default :
-                    n = 0U;
-                    break;
+        // as in fmt_vctxprintf()
+        unsigned int cc = _fmt_cclass[(unsigned char) *format];
+        if (CC_CLASS(cc) == C_SPEC && _ctx.argc) {
+            if (!_is_installed(locale, (unsigned char) *format) && _fast_arg(&_ctx, _ctx.argv, *format)) {
+                _ctx.argv++;
+                _ctx.argc--;
+                format++;
+                continue;
             }
-        } while (n);
-
-        // evaluate width field
+        }
+        state.flags = 0U;
         state.width = 0U;
-        if (_is_digit(*format)) {
-            state.width = _atoi(&format);
-        } else if (*format == '*') {
-            const int w = va_arg(*state.args, int);
-            if (w < 0) {
-                state.flags |= FMT_FLAG_LEFT;    // reverse padding
-                state.width = (unsigned int) -w;
-            } else {
-                state.width = (unsigned int) w;
+        state.precision = 0U;
+        state.size = FMT_SIZE_DEFAULT;
+        if (CC_CLASS(cc) != C_SPEC) {
+            const char *rest = format;
+            cc = _parse(&rest, &state, cc, NULL);
+            format = rest;
+            if (CC_CLASS(cc) == C_END) {
+                break;
             }
-            format++;
+        }
+        state.specifier = *format;
+        format++;
+        const int conv = CC_CLASS(cc) == C_SPEC && CC_VALUE(cc) != CONV_POS ? (int) CC_VALUE(cc) : CONV_NONE;
+        if (state.flags & _FMT_FLAG_WIDTH_STAR) {
+            _fmt_set_width(&state, (int) fmt_conv_arg(&state, FMT_TYPE_INT).i);
+        }
+        if (state.flags & _FMT_FLAG_PREC_STAR) {
+            _fmt_set_precision(&state, (int) fmt_conv_arg(&state, FMT_TYPE_INT).i);
+        }
+        state.flags &= ~(_FMT_FLAG_WIDTH_STAR | _FMT_FLAG_PREC_STAR);
+        if (_ctx.bad_arg) {
+            return -1;
         }
 
-        // evaluate precision field
-        state.precision = 0U;
-        if (*format == '.') {
-            state.flags |= FMT_FLAG_PRECISION;
-            format++;
-            if (_is_digit(*format)) {
-                state.precision = _atoi(&format);
-            } else if (*format == '*') {
-                const int prec = (int) va_arg(*state.args, int);
-                state.precision = prec > 0 ? (unsigned int) prec : 0U;
-                format++;
-            }
+        if (__builtin_expect(_is_installed(locale, (unsigned char) state.specifier), 0)) {
+            _run_installed(locale, &state);
+        } else if (conv == CONV_PCT || conv == CONV_NONE) {
+            _fmt_convert(&state, (enum _fmt_conv) conv, (union _fmt_value){0});
+        } else if (!_ctx.argc || !_fmt_type_suits(_ctx.argv->type, (enum _fmt_conv) conv)) {
+            return -1;
+        } else {
+            _fmt_convert_arg(&state, (enum _fmt_conv) conv, _ctx.argv++);
+            _ctx.argc--;
+        }
+        if (_ctx.bad_arg) {
+            return -1;
         }
+    }
 
-        // evaluate length field
-        state.size = FMT_SIZE_DEFAULT;
-        switch (*format) {
-            case 'l' :
-                state.size = FMT_SIZE_LONG;
-                format++;
-                if (*format == 'l') {
-                    state.size = FMT_SIZE_LONG_LONG;
-                    format++;
-                }
-                break;
-            case 'h' :
-                state.size = FMT_SIZE_SHORT;
-                format++;
-                if (*format == 'h') {
-                    state.size = FMT_SIZE_CHAR;
-                    format++;
-                }
-                break;
-#if PICO_PRINTF_SUPPORT_PTRDIFF_T
-            case 't' :
-                state.size = (sizeof(ptrdiff_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG);
-                format++;
-                break;
-#endif
-            case 'j' :
-                state.size = (sizeof(intmax_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG);
-                format++;
-                break;
-            case 'z' :
-                state.size = (sizeof(size_t) == sizeof(long) ? FMT_SIZE_LONG : FMT_SIZE_LONG_LONG);
-                format++;
-                break;
-            default :
-                break;
+    return (int) _ctx.idx;
+}
+
+PICO_FMT_API int fmt_fctprintf_spec(fmt_fct_t fct, void *arg, const struct fmt_spec *specs, size_t n, const struct fmt_arg *args) {
+    struct _fmt_ctx _ctx = {
+        .fct = fct,
+        .arg = arg,
+        .idx = 0,
+    };
+
+    for (const struct fmt_spec *spec = specs; spec < &specs[n]; spec++) {
+        for (size_t i = 0; i < spec->lit_len; i++) {
+            out(spec->lit[i], &_ctx);
+        }
+        if (!spec->specifier) {
+            continue;
+        }
+        if (!spec->flags && !spec->width && _fast_arg(&_ctx, args, spec->specifier)) {
+            args++;
+            continue;
         }
 
-        // evaluate specifier
-        state.specifier = *format;
-        format++;
-        if (specifier_table[(unsigned int) state.specifier]) {
-            specifier_table[(unsigned int) state.specifier](state);
+        struct fmt_state state = {
+            .flags     = spec->flags & ~(FMT_SPEC_WIDTH_STAR | FMT_SPEC_PREC_STAR),
+            .width     = spec->width,
+            .precision = spec->precision,
+            .size      = FMT_SIZE_DEFAULT,
+            .specifier = spec->specifier,
+            .args      = NULL,
+            .ctx       = &_ctx,
+        };
+        if (spec->flags & FMT_SPEC_WIDTH_STAR) {
+            _fmt_set_width(&state, (int) (args++)->i);
+        }
+        if (spec->flags & FMT_SPEC_PREC_STAR) {
+            _fmt_set_precision(&state, (int) (args++)->i);
+        }
+        const unsigned int cc = _fmt_cclass[(unsigned char) spec->specifier];
+        const enum _fmt_conv conv = CC_CLASS(cc) == C_SPEC ? (enum _fmt_conv) CC_VALUE(cc) : CONV_NONE;
+        if (conv == CONV_PCT || conv == CONV_NONE || conv == CONV_POS) {
+            _fmt_convert(&state, conv, (union _fmt_value){0});
         } else {
-            out(state.specifier, state.ctx);
+            _fmt_convert_arg(&state, conv, args++);
         }
     }
 
-    va_end(_va_save);
     return (int) _ctx.idx;
 }
 
-static void conv_sint(struct fmt_state state) {
+static void conv_sint(struct fmt_state *state) {
     const unsigned int base = 10;
-    switch (state.size) {
+    switch (state->size) {
 #if PICO_PRINTF_SUPPORT_LONG_LONG
         case FMT_SIZE_LONG_LONG: {
-            const long long value = va_arg(*state.args, long long);
+            const long long value = va_arg(*state->args, long long);
             _ntoa_long_long(state, (unsigned long long) (value > 0 ? value : 0 - value), value < 0, base);
             break;
         }
@@ -724,170 +1528,239 @@ static void conv_sint(struct fmt_state state) {
         case FMT_SIZE_LONG_LONG: // fall through
 #endif
         case FMT_SIZE_LONG: {
-            const long value = va_arg(*state.args, long);
-            _ntoa_long(state, (unsigned long) (value > 0 ? value : 0 - value), value < 0, base);
+            const long value = va_arg(*state->args, long);
+            _fmt_ntoa_long(state, (unsigned long) (value > 0 ? value : 0 - value), value < 0, base);
             break;
         }
         case FMT_SIZE_DEFAULT: {
-            const int value = va_arg(*state.args, int);
-            _ntoa_long(state, (unsigned int) (value > 0 ? value : 0 - value), value < 0, base);
+            const int value = va_arg(*state->args, int);
+            _fmt_ntoa_long(state, (unsigned int) (value > 0 ? value : 0 - value), value < 0, base);
             break;
         }
         case FMT_SIZE_SHORT: {
             // 'short' is promoted to 'int' when passed through '...'; so we read it
-            // with va_arg(*state.args, int), but then truncate it with casting.
-            const int value = (short int) va_arg(*state.args, int);
-            _ntoa_long(state, (unsigned int) (value > 0 ? value : 0 - value), value < 0, base);
+            // with va_arg(*state->args, int), but then truncate it with casting.
+            const int value = (short int) va_arg(*state->args, int);
+            _fmt_ntoa_long(state, (unsigned int) (value > 0 ? value : 0 - value), value < 0, base);
             break;
         }
         case FMT_SIZE_CHAR: {
             // 'char' is promoted to 'int' when passed through '...'; so we read it
-            // with va_arg(*state.args, int), but then truncate it with casting.
-            const int value = (char) va_arg(*state.args, int);
-            _ntoa_long(state, (unsigned int) (value > 0 ? value : 0 - value), value < 0, base);
+            // with va_arg(*state->args, int), but then truncate it with casting.
+            const int value = (char) va_arg(*state->args, int);
+            _fmt_ntoa_long(state, (unsigned int) (value > 0 ? value : 0 - value), value < 0, base);
             break;
         }
     }
 }
 
-static void conv_uint(struct fmt_state state) {
-    unsigned int base;
-    switch (state.specifier) {
-        case 'u' :
-            base = 10;
-            break;
+// the base for an integer specifier; 10 for 'd', 'i', 'u' (and anything
+// that fmt_conv_int()/fmt_conv_uint() are given that isn't a base)
+static inline unsigned int _uint_base(char specifier) {
+    switch (specifier) {
         case 'x' :
         case 'X' :
-            base = 16;
-            break;
+            return 16;
         case 'o' :
-            base = 8;
-            break;
+            return 8;
         case 'b' :
-            base = 2;
-            break;
+            return 2;
         default:
-            __builtin_unreachable();
+            return 10;
     }
+}
+
+static void conv_uint(struct fmt_state *state) {
+    const unsigned int base = _uint_base(state->specifier);
 
-    state.flags &= ~(FMT_FLAG_PLUS | FMT_FLAG_SPACE);
-    switch (state.size) {
+    state->flags &= ~(FMT_FLAG_PLUS | FMT_FLAG_SPACE);
+    switch (state->size) {
         case FMT_SIZE_LONG_LONG:
 #if PICO_PRINTF_SUPPORT_LONG_LONG
-            _ntoa_long_long(state, va_arg(*state.args, unsigned long long), false, base);
+            _ntoa_long_long(state, va_arg(*state->args, unsigned long long), false, base);
             break;
 #else
             // fall through
 #endif
         case FMT_SIZE_LONG:
-            _ntoa_long(state, va_arg(*state.args, unsigned long), false, base);
+            _fmt_ntoa_long(state, va_arg(*state->args, unsigned long), false, base);
             break;
         case FMT_SIZE_DEFAULT:
-            _ntoa_long(state, va_arg(*state.args, unsigned int), false, base);
+            _fmt_ntoa_long(state, va_arg(*state->args, unsigned int), false, base);
             break;
         case FMT_SIZE_SHORT:
             // 'short' is promoted to 'int' when passed through '...'; so we read it
-            // with va_arg(*state.args, unsigned int), but then truncate it with casting.
-            _ntoa_long(state, (unsigned short int) va_arg(*state.args, unsigned int), false, base);
+            // with va_arg(*state->args, unsigned int), but then truncate it with casting.
+            _fmt_ntoa_long(state, (unsigned short int) va_arg(*state->args, unsigned int), false, base);
             break;
         case FMT_SIZE_CHAR:
             // 'char' is promoted to 'int' when passed through '...'; so we read it
-            // with va_arg(*state.args, unsigned int), but then truncate it with casting.
-            _ntoa_long(state, (unsigned char) va_arg(*state.args, unsigned int), false, base);
+            // with va_arg(*state->args, unsigned int), but then truncate it with casting.
+            _fmt_ntoa_long(state, (unsigned char) va_arg(*state->args, unsigned int), false, base);
             break;
     }
 }
 
-static void conv_double(struct fmt_state state) {
-    switch (state.specifier) {
-#if PICO_PRINTF_SUPPORT_FLOAT
-        case 'f' :
-        case 'F' :
-            {
-                double value = va_arg(*state.args, double);
-                // test for very large values
-                // standard printf behavior is to print EVERY whole number digit -- which could be 100s of characters overflowing your buffers == bad
-                if ((value > PICO_PRINTF_MAX_FLOAT && value < DBL_MAX)
-                    || (value < -PICO_PRINTF_MAX_FLOAT && value > -DBL_MAX)) {
-#if PICO_PRINTF_SUPPORT_EXPONENTIAL
-                    _etoa(state, value, false);
-#endif
-                    break;
-                }
-                _ftoa(state, value);
-            }
-            break;
-        case 'e':
-        case 'E':
-#if PICO_PRINTF_SUPPORT_EXPONENTIAL
-            _etoa(state, va_arg(*state.args, double), false);
-            break;
-        case 'g':
-        case 'G':
-            _etoa(state, va_arg(*state.args, double), true);
-            break;
+// used when printf_float.c isn't linked in (or PICO_PRINTF_SUPPORT_FLOAT is off)
+#if !PICO_FMT_AMALGAMATED || !PICO_PRINTF_SUPPORT_FLOAT
+#if !PICO_FMT_AMALGAMATED
+__attribute__((weak))
 #endif
-#endif
-        default:
-            for(int i=0;i<2;i++) out('?', state.ctx);
-            va_arg(*state.args, double);
-    }
+PICO_FMT_API void _fmt_dtoa(struct fmt_state *state, double value) {
+    (void) value;
+    for(int i=0;i<2;i++) out('?', state->ctx);
 }
+#endif
 
-static void conv_char(struct fmt_state state) {
-    unsigned int l = 1U;
+static void _conv_char(struct fmt_state *state, char character) {
+    const size_t pad = state->width > 1U ? state->width - 1U : 0U;
     // pre padding
-    if (!(state.flags & FMT_FLAG_LEFT)) {
-        while (l++ < state.width) {
-            out(' ', state.ctx);
-        }
+    if (!(state->flags & FMT_FLAG_LEFT)) {
+        _out_fill(state->ctx, ' ', pad);
     }
     // char output
-    out((char) va_arg(*state.args, int), state.ctx);
+    out(character, state->ctx);
     // post padding
-    if (state.flags & FMT_FLAG_LEFT) {
-        while (l++ < state.width) {
-            out(' ', state.ctx);
-        }
+    if (state->flags & FMT_FLAG_LEFT) {
+        _out_fill(state->ctx, ' ', pad);
     }
 }
 
-static void conv_str(struct fmt_state state) {
-    const char *p = va_arg(*state.args, char*);
-    unsigned int l = _strnlen_s(p, state.precision ? state.precision : (size_t) -1);
+static void conv_char(struct fmt_state *state) {
+    _conv_char(state, (char) va_arg(*state->args, int));
+}
+
+static void _conv_str(struct fmt_state *state, const char *p) {
+    // (reading no further than the precision, even if it's 0)
+    const unsigned int l = _strnlen_s(p, state->flags & FMT_FLAG_PRECISION ? state->precision : (size_t) -1);
     // pre padding
-    if (state.flags & FMT_FLAG_PRECISION) {
-        l = (l < state.precision ? l : state.precision);
-    }
-    if (!(state.flags & FMT_FLAG_LEFT)) {
-        while (l++ < state.width) {
-            out(' ', state.ctx);
-        }
+    const size_t pad = l < state->width ? state->width - l : 0U;
+    if (!(state->flags & FMT_FLAG_LEFT)) {
+        _out_fill(state->ctx, ' ', pad);
     }
     // string output
-    while ((*p != 0) && (!(state.flags & FMT_FLAG_PRECISION) || state.precision--)) {
-        out(*(p++), state.ctx);
+    for (unsigned int i = 0; i < l; i++) {
+        out(p[i], state->ctx);
     }
     // post padding
-    if (state.flags & FMT_FLAG_LEFT) {
-        while (l++ < state.width) {
-            out(' ', state.ctx);
-        }
+    if (state->flags & FMT_FLAG_LEFT) {
+        _out_fill(state->ctx, ' ', pad);
     }
 }
 
-static void conv_ptr(struct fmt_state state) {
-    state.width = sizeof(void *) * 2U;
-    state.flags |= FMT_FLAG_ZEROPAD;
-    state.specifier = 'X';
+static void conv_str(struct fmt_state *state) {
+    _conv_str(state, va_arg(*state->args, char*));
+}
+
+static void _conv_ptr(struct fmt_state *state, uintptr_t value) {
+    state->width = sizeof(void *) * 2U;
+    state->flags |= FMT_FLAG_ZEROPAD;
+    state->specifier = 'X';
 #if PICO_PRINTF_SUPPORT_LONG_LONG
     if (sizeof(uintptr_t) == sizeof(long long))
-        _ntoa_long_long(state, (uintptr_t) va_arg(*state.args, void*), false, 16U);
+        _ntoa_long_long(state, value, false, 16U);
     else
 #endif
-        _ntoa_long(state, (unsigned long) ((uintptr_t) va_arg(*state.args, void*)), false, 16U);
+        _fmt_ntoa_long(state, (unsigned long) value, false, 16U);
+}
+
+static void conv_ptr(struct fmt_state *state) {
+    _conv_ptr(state, (uintptr_t) va_arg(*state->args, void*));
+}
+
+static void conv_pct(struct fmt_state *state) {
+    out('%', state->ctx);
+}
+
+static void _conv_int(struct fmt_state *state, long long value, unsigned int base) {
+    const unsigned long long abs = value < 0 ? 0ULL - (unsigned long long) value : (unsigned long long) value;
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+    if (abs > (unsigned long) -1) {
+        _ntoa_long_long(state, abs, value < 0, base);
+        return;
+    }
+#endif
+    _fmt_ntoa_long(state, (unsigned long) abs, value < 0, base);
+}
+
+static void _conv_uint(struct fmt_state *state, unsigned long long value, unsigned int base) {
+    state->flags &= ~(FMT_FLAG_PLUS | FMT_FLAG_SPACE);
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+    if (value > (unsigned long) -1) {
+        _ntoa_long_long(state, value, false, base);
+        return;
+    }
+#endif
+    _fmt_ntoa_long(state, (unsigned long) value, false, base);
+}
+
+PICO_FMT_API void _fmt_convert(struct fmt_state *state, enum _fmt_conv conv, union _fmt_value value) {
+    switch (conv) {
+        case CONV_SINT:
+            // (fmt_fctformat_args() also passes signed "x", "o" and "b" here)
+            _conv_int(state, value.i, _uint_base(state->specifier));
+            break;
+        case CONV_UINT:
+            _conv_uint(state, value.u, _uint_base(state->specifier));
+            break;
+        case CONV_DOUBLE:
+            _fmt_dtoa(state, value.f);
+            break;
+        case CONV_CHAR:
+            _conv_char(state, (char) value.i);
+            break;
+        case CONV_STR:
+            _conv_str(state, value.s);
+            break;
+        case CONV_PTR:
+            _conv_ptr(state, (uintptr_t) value.p);
+            break;
+        case CONV_PCT:
+            conv_pct(state);
+            break;
+        case CONV_POS:
+        case CONV_NONE:
+            out(state->specifier, state->ctx);
+            break;
+    }
+}
+
+// Conversion toolkit //////////////////////////////////////////////////////////
+//
+// The pieces of the above, for installed specifiers.
+
+PICO_FMT_API void fmt_conv_write(struct fmt_state *state, const char *buf, size_t len) {
+    struct _fmt_ctx *ctx = state->ctx;
+#if PICO_PRINTF_BUFFER_SINK
+    if (!ctx->fct) {
+        if (len && ctx->idx < ctx->maxlen) {
+            const size_t room = ctx->maxlen - ctx->idx;
+            memcpy(&ctx->buffer[ctx->idx], buf, len < room ? len : room);
+        }
+        ctx->idx += len;
+        return;
+    }
+#endif
+    while (len--) {
+        out(*buf++, ctx);
+    }
+}
+
+PICO_FMT_API void fmt_conv_pad(struct fmt_state *state, char character, size_t n) {
+    _out_fill(state->ctx, character, n);
+}
+
+PICO_FMT_API void fmt_conv_int(struct fmt_state *state, long long value, char specifier) {
+    state->specifier = specifier;
+    _conv_int(state, value, _uint_base(specifier));
+}
+
+PICO_FMT_API void fmt_conv_uint(struct fmt_state *state, unsigned long long value, char specifier) {
+    state->specifier = specifier;
+    _conv_uint(state, value, _uint_base(specifier));
 }
 
-static void conv_pct(struct fmt_state state) {
-    out('%', state.ctx);
+PICO_FMT_API void fmt_conv_double(struct fmt_state *state, double value, char specifier) {
+    state->specifier = specifier;
+    _fmt_dtoa(state, value);
 }
@@ -0,0 +1,300 @@
+// Copyright (c) 2014-2019  Marco Paland (info@paland.com)
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2020  Raspberry Pi (Trading) Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// The floating-point conversions (%f %F %e %E %g %G).  These are the
+// bulk of the formatter's code, so they live in their own translation
+// unit (the pico_fmt_float library) that an executable may leave out;
+// see pico_fmt_omit_float() in CMakeLists.txt.
+
+#include <stdint.h>
+
+#include "printf_internal.h"
+
+#if PICO_PRINTF_SUPPORT_FLOAT
+
+// import float.h for DBL_MAX
+#include <float.h>
+
+#define is_nan __builtin_isnan
+
+static bool _float_special(const struct fmt_state *state, double value) {
+    // test for special values
+    if (is_nan(value)) {
+        _fmt_out_padded(state, "nan", 3);
+        return true;
+    }
+    if (value < -DBL_MAX) {
+        _fmt_out_padded(state, "-inf", 4);
+        return true;
+    }
+    if (value > DBL_MAX) {
+        _fmt_out_padded(state, (state->flags & FMT_FLAG_PLUS) ? "+inf" : "inf", (state->flags & FMT_FLAG_PLUS) ? 4U : 3U);
+        return true;
+    }
+    return false;
+}
+
+// internal ftoa for fixed decimal floating point; like the itoa
+// functions, this works out how long each part is and then outputs
+// it in order, rather than buffering it up
+static void _ftoa(struct fmt_state *state, double value) {
+    double diff = 0.0;
+
+#if PICO_PRINTF_OPTIMIZE_SPEED
+    // powers of 10
+    static const double pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+#endif
+
+    // check for NaN and special values
+    if (_float_special(state, value))
+        return;
+
+    // test for negative
+    bool negative = false;
+    if (value < 0) {
+        negative = true;
+        value = 0 - value;
+    }
+
+    // set default precision, if not set explicitly
+    if (!(state->flags & FMT_FLAG_PRECISION)) {
+        state->precision = PICO_PRINTF_DEFAULT_FLOAT_PRECISION;
+    }
+    // limit precision to 9, cause a prec >= 10 can lead to overflow
+    // errors; the rest are trailing zeros
+    unsigned int extra_zeros = 0U;
+    if (state->precision > 9U) {
+        extra_zeros = state->precision - 9U;
+        state->precision = 9U;
+    }
+
+#if PICO_PRINTF_OPTIMIZE_SPEED
+    const double scale = pow10[state->precision];
+#else
+    double scale = 1.0;
+    for (unsigned int i = 0; i < state->precision; i++) {
+        scale *= 10.0; // exact, this far
+    }
+#endif
+
+    int whole = (int) value;
+    double tmp = (value - whole) * scale;
+    unsigned long frac = (unsigned long) tmp;
+    diff = tmp - frac;
+
+    if (diff > 0.5) {
+        ++frac;
+        // handle rollover, e.g. case 0.99 with prec 1 is 1.0
+        if (frac >= scale) {
+            frac = 0;
+            ++whole;
+        }
+    } else if (diff < 0.5) {
+    } else if ((frac == 0U) || (frac & 1U)) {
+        // if halfway, round up if odd OR if last digit is 0
+        ++frac;
+    }
+
+    if (state->precision == 0U) {
+        diff = value - (double) whole;
+        if (!((diff < 0.5) || (diff > 0.5)) && (whole & 1)) {
+            // exactly 0.5 and ODD, then round up
+            // 1.5 -> 2, but 2.5 -> 2
+            ++whole;
+        }
+    }
+
+    // measure the whole part, and the fractional part with its decimal
+    size_t len = 1U;
+    unsigned int whole_place = 1U;
+    while (whole_place <= (unsigned int) whole / 10U) {
+        whole_place *= 10U;
+        len++;
+    }
+    unsigned int frac_place = 1U;
+    if (state->precision) {
+        for (unsigned int i = 1U; i < state->precision; i++) {
+            frac_place *= 10U;
+        }
+        len += 1U + state->precision + extra_zeros;
+    }
+
+    // the padding and sign are as for an integer (with no precision)
+    const unsigned int precision = state->precision;
+    state->flags &= ~(FMT_FLAG_PRECISION | FMT_FLAG_HASH);
+    state->precision = 0U;
+    _fmt_ntoa_format(state, len, negative, 10U);
+    _fmt_out_dec(state->ctx, (unsigned int) whole, whole_place);
+    if (precision) {
+        out('.', state->ctx);
+        _fmt_out_dec(state->ctx, (unsigned int) frac, frac_place);
+        _out_fill(state->ctx, '0', extra_zeros);
+    }
+    _out_fill(state->ctx, ' ', state->width);
+}
+
+
+#if PICO_PRINTF_SUPPORT_EXPONENTIAL
+
+// internal ftoa variant for exponential floating-point type, contributed by Martijn Jasperse <m.jasperse@gmail.com>
+static void _etoa(struct fmt_state *state, double value, bool adapt_exp) {
+    // check for NaN and special values
+    if (_float_special(state, value))
+        return;
+
+    // determine the sign
+    const bool negative = value < 0;
+    if (negative) {
+        value = -value;
+    }
+
+    // default precision
+    if (!(state->flags & FMT_FLAG_PRECISION)) {
+        state->precision = PICO_PRINTF_DEFAULT_FLOAT_PRECISION;
+    }
+
+    // determine the decimal exponent
+    // based on the algorithm by David Gay (https://www.ampl.com/netlib/fp/dtoa.c)
+    union {
+        uint64_t U;
+        double F;
+    } conv;
+
+    conv.F = value;
+    int expval;
+    if (conv.U) {
+        int exp2 = (int) ((conv.U >> 52U) & 0x07FFU) - 1023;           // effectively log2
+        conv.U = (conv.U & ((1ULL << 52U) - 1U)) | (1023ULL << 52U);  // drop the exponent so conv.F is now in [1,2)
+        // now approximate log10 from the log2 integer part and an expansion of ln around 1.5
+        expval = (int) (0.1760912590558 + exp2 * 0.301029995663981 + (conv.F - 1.5) * 0.289529654602168);
+        // now we want to compute 10^expval but we want to be sure it won't overflow
+        exp2 = (int) (expval * 3.321928094887362 + 0.5);
+        const double z = expval * 2.302585092994046 - exp2 * 0.6931471805599453;
+        const double z2 = z * z;
+        conv.U = (uint64_t) (exp2 + 1023) << 52U;
+        // compute exp(z) using continued fractions, see https://en.wikipedia.org/wiki/Exponential_function#Continued_fractions_for_ex
+        conv.F *= 1 + 2 * z / (2 - z + (z2 / (6 + (z2 / (10 + z2 / 14)))));
+        // correct for rounding errors
+        if (value < conv.F) {
+            expval--;
+            conv.F /= 10;
+        }
+    } else {
+        expval = 0;
+    }
+
+    // the exponent format is "%+03d" and largest value is "307", so set aside 4-5 characters
+    unsigned int minwidth = ((expval < 100) && (expval > -100)) ? 4U : 5U;
+
+    // in "%g" mode, "state->precision" is the number of *significant figures* not decimals
+    if (adapt_exp) {
+        // do we want to fall-back to "%f" mode?
+        if ((conv.U == 0) || ((value >= 1e-4) && (value < 1e6))) {
+            if ((int) state->precision > expval) {
+                state->precision = (unsigned) ((int) state->precision - expval - 1);
+            } else {
+                state->precision = 0;
+            }
+            state->flags |= FMT_FLAG_PRECISION;   // make sure _ftoa respects precision
+            // no characters in exponent
+            minwidth = 0U;
+            expval = 0;
+        } else {
+            // we use one sigfig for the whole part
+            if ((state->precision > 0) && (state->flags & FMT_FLAG_PRECISION)) {
+                --state->precision;
+            }
+        }
+    }
+
+    // will everything fit?
+    unsigned int fwidth = state->width;
+    if (fwidth > minwidth) {
+        // we didn't fall-back so subtract the characters required for the exponent
+        fwidth -= minwidth;
+    } else {
+        // not enough characters, so go back to default sizing
+        fwidth = 0U;
+    }
+    if ((state->flags & FMT_FLAG_LEFT) && minwidth) {
+        // if we're padding on the right, DON'T pad the floating part
+        fwidth = 0U;
+    }
+
+    // rescale the float value
+    if (expval) {
+        value /= conv.F;
+    }
+
+    // output the floating part; re-use *state for it (and then for the
+    // exponent) rather than building up sub-states, but hang on to what
+    // we still need from it afterward
+    const size_t start_idx = state->ctx->idx;
+    const unsigned int width = state->width;
+    const bool left = state->flags & FMT_FLAG_LEFT;
+    const bool upper = _is_upper(state->specifier);
+    state->width = fwidth;
+    state->specifier = 'f';
+    _ftoa(state, negative ? -value : value);
+
+    // output the exponent part
+    if (minwidth) {
+        // output the exponential symbol
+        out(upper ? 'E' : 'e', state->ctx);
+        // output the exponent value
+        state->width = minwidth - 1;
+        state->precision = 0;
+        state->flags = FMT_FLAG_ZEROPAD | FMT_FLAG_PLUS;
+        state->specifier = 'u';
+        _fmt_ntoa_long(state, (unsigned int)((expval < 0) ? -expval : expval), expval < 0, 10);
+        // might need to right-pad spaces
+        if (left) {
+            const size_t n = state->ctx->idx - start_idx;
+            if (n < width) {
+                _out_fill(state->ctx, ' ', width - n);
+            }
+        }
+    }
+}
+
+#endif  // PICO_PRINTF_SUPPORT_EXPONENTIAL
+
+PICO_FMT_API void _fmt_dtoa(struct fmt_state *state, double value) {
+    switch (state->specifier) {
+        case 'f' :
+        case 'F' :
+            {
+                // test for very large values
+                // standard printf behavior is to print EVERY whole number digit -- which could be 100s of characters overflowing your buffers == bad
+                if ((value > PICO_PRINTF_MAX_FLOAT && value <= DBL_MAX)
+                    || (value < -PICO_PRINTF_MAX_FLOAT && value >= -DBL_MAX)) {
+#if PICO_PRINTF_SUPPORT_EXPONENTIAL
+                    _etoa(state, value, false);
+#endif
+                    break;
+                }
+                _ftoa(state, value);
+            }
+            break;
+#if PICO_PRINTF_SUPPORT_EXPONENTIAL
+        case 'e':
+        case 'E':
+            _etoa(state, value, false);
+            break;
+        case 'g':
+        case 'G':
+            _etoa(state, value, true);
+            break;
+#endif
+        default:
+            for(int i=0;i<2;i++) out('?', state->ctx);
+    }
+}
+
+#endif  // PICO_PRINTF_SUPPORT_FLOAT
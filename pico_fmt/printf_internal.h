@@ -0,0 +1,393 @@
+// Copyright (c) 2014-2019  Marco Paland (info@paland.com)
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2020  Raspberry Pi (Trading) Ltd.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Shared between printf.c and the separately-linked conversion
+// families (printf_float.c); not part of the public API.
+
+#ifndef _PICO_FMT_PRINTF_INTERNAL_H
+#define _PICO_FMT_PRINTF_INTERNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>  /* for memset() */
+
+#include "pico/fmt_printf.h"
+#include "pico/fmt_install.h"
+#include "pico/fmt_maxlen.h"
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_FLOAT, Enable floating point printing, type=bool, default=1, group=pico_printf
+// support for the floating point type (%f)
+#ifndef PICO_PRINTF_SUPPORT_FLOAT
+#define PICO_PRINTF_SUPPORT_FLOAT 1
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_EXPONENTIAL, Enable exponential floating point printing, type=bool, default=1, group=pico_printf
+// support for exponential floating point notation (%e/%g)
+#ifndef PICO_PRINTF_SUPPORT_EXPONENTIAL
+#define PICO_PRINTF_SUPPORT_EXPONENTIAL 1
+#endif
+
+// (PICO_PRINTF_DEFAULT_FLOAT_PRECISION and PICO_PRINTF_MAX_FLOAT are in
+// fmt_maxlen.h, which needs them too.)
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_LONG_LONG, Enable support for long long types (%llu or %p), type=bool, default=1, group=pico_printf
+#ifndef PICO_PRINTF_SUPPORT_LONG_LONG
+#define PICO_PRINTF_SUPPORT_LONG_LONG 1
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_SUPPORT_PTRDIFF_T, Enable support for the ptrdiff_t type (%t), type=bool, default=1, group=pico_printf
+// ptrdiff_t is normally defined in <stddef.h> as long or long long type
+#ifndef PICO_PRINTF_SUPPORT_PTRDIFF_T
+#define PICO_PRINTF_SUPPORT_PTRDIFF_T 1
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_MAX_POSITIONAL_ARGS, Define the highest N that may be used in a "%N$" positional directive; each costs some on-stack space, min=1, default=16, group=pico_printf
+#ifndef PICO_PRINTF_MAX_POSITIONAL_ARGS
+#define PICO_PRINTF_MAX_POSITIONAL_ARGS 16U
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_OPTIMIZE, Favor code size ("size": compact loops, every directive through the general path) or speed ("speed": digit and power-of-ten tables, bulk padding and inlined fast paths), default=speed, group=pico_printf
+#ifndef PICO_PRINTF_OPTIMIZE
+#define PICO_PRINTF_OPTIMIZE speed
+#endif
+#define _PICO_PRINTF_OPTIMIZE_size  1
+#define _PICO_PRINTF_OPTIMIZE_speed 2
+#define __PICO_PRINTF_OPTIMIZE(profile) _PICO_PRINTF_OPTIMIZE_##profile
+#define _PICO_PRINTF_OPTIMIZE(profile) __PICO_PRINTF_OPTIMIZE(profile)
+#if !_PICO_PRINTF_OPTIMIZE(PICO_PRINTF_OPTIMIZE)
+#error PICO_PRINTF_OPTIMIZE must be size or speed
+#endif
+// for #if
+#define PICO_PRINTF_OPTIMIZE_SPEED (_PICO_PRINTF_OPTIMIZE(PICO_PRINTF_OPTIMIZE) == _PICO_PRINTF_OPTIMIZE_speed)
+
+// PICO_CONFIG: PICO_PRINTF_BUFFER_SINK, Have fmt_vsnprintf and fmt_snprintf write straight in to the buffer rather than calling an output function for each character; this makes them faster but everything else a little slower (and bigger), type=bool, default=0 (1 in the single-header pico_fmt.h), group=pico_printf
+#ifndef PICO_PRINTF_BUFFER_SINK
+#define PICO_PRINTF_BUFFER_SINK PICO_FMT_AMALGAMATED
+#endif
+
+// Whether this is the single-header pico_fmt.h, in which everything is
+// in one translation unit (see cmake/pico_fmt_amalgamate.cmake).
+#ifndef PICO_FMT_AMALGAMATED
+#define PICO_FMT_AMALGAMATED 0
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct _fmt_ctx {
+    fmt_fct_t    fct;
+    void        *arg;
+    size_t       idx;
+
+    // the remaining arguments, when formatting from a struct fmt_arg
+    // array rather than a va_list
+    const struct fmt_arg *argv;
+    size_t       argc;
+    bool         bad_arg; // a directive had no argument or one of the wrong kind
+
+    // the caps, when formatting with fmt_vfctprintf_limited(); else NULL
+    const struct fmt_limits *limits;
+    unsigned int directives; // how many directives so far, if limits
+    bool         limited;    // one of the limits was reached
+
+    // for fmt_conv_printf() from an installed specifier; set just
+    // before running it
+    const struct fmt_locale *locale;
+
+#if PICO_PRINTF_BUFFER_SINK
+    // if there's no fct, output goes straight in to buffer[0:maxlen]
+    // (maxlen being 0 if there's nowhere to put it); see fmt_vsnprintf()
+    char        *buffer;
+    size_t       maxlen;
+#endif
+};
+
+static inline void out(char character, struct _fmt_ctx *ctx) {
+    if (ctx->fct) {
+        ctx->fct(character, ctx->arg);
+    }
+#if PICO_PRINTF_BUFFER_SINK
+    else if (ctx->idx < ctx->maxlen) {
+        ctx->buffer[ctx->idx] = character;
+    }
+#endif
+    ctx->idx++;
+}
+
+// out() `character` n times
+static inline void _out_fill(struct _fmt_ctx *ctx, char character, size_t n) {
+#if PICO_PRINTF_OPTIMIZE_SPEED
+    if (!ctx->fct) {
+#if PICO_PRINTF_BUFFER_SINK
+        if (n && ctx->idx < ctx->maxlen) {
+            const size_t room = ctx->maxlen - ctx->idx;
+            memset(&ctx->buffer[ctx->idx], character, n < room ? n : room);
+        }
+#endif
+        ctx->idx += n;
+        return;
+    }
+#endif
+    while (n--) {
+        out(character, ctx);
+    }
+}
+
+static inline bool _is_upper(char ch) {
+    return (ch >= 'A') && (ch <= 'Z');
+}
+
+#if PICO_PRINTF_OPTIMIZE_SPEED
+// for converting two decimal digits at a time: "00" through "99" (as a
+// string literal, so that the linker merges the copies)
+#define _FMT_DIGIT_PAIRS                                               \
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839" \
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879" \
+    "8081828384858687888990919293949596979899"
+
+// the digits for base 2 through 16
+#define _FMT_DIGITS(upper) ((upper) ? "0123456789ABCDEF" : "0123456789abcdef")
+#endif
+
+// output the decimal digits of `value`, most-significant first; `place`
+// is the place value of the first (so leading zeros are output if it
+// calls for them)
+PICO_FMT_API void _fmt_out_dec(struct _fmt_ctx *ctx, unsigned int value, unsigned int place);
+
+// Bare "%d" and "%x" (no flags, width, precision or length), without
+// going through struct fmt_state or _fmt_ntoa_format.  Like the itoa
+// functions, these find the place value of the first digit, and then
+// output the digits most-significant first.
+static inline void _fast_dec(struct _fmt_ctx *ctx, unsigned int value, bool negative) {
+    unsigned int place = 1U;
+    while (place <= value / 10U) {
+        place *= 10U;
+    }
+    if (negative) {
+        out('-', ctx);
+    }
+    _fmt_out_dec(ctx, value, place);
+}
+
+static inline void _fast_hex(struct _fmt_ctx *ctx, unsigned int value, bool upper) {
+    unsigned int shift = 0U;
+    while (value >> shift >> 4U) {
+        shift += 4U;
+    }
+#if PICO_PRINTF_OPTIMIZE_SPEED
+    const char *digits = _FMT_DIGITS(upper);
+#else
+    const char a = upper ? 'A' : 'a';
+#endif
+    for (;; shift -= 4U) {
+        const char digit = (char) ((value >> shift) & 0xFU);
+#if PICO_PRINTF_OPTIMIZE_SPEED
+        out(digits[(unsigned char) digit], ctx);
+#else
+        out((char) (digit < 10 ? '0' + digit : a + digit - 10), ctx);
+#endif
+        if (!shift) {
+            break;
+        }
+    }
+}
+
+// output the specified string, taking care of any space-padding
+PICO_FMT_API void _fmt_out_padded(const struct fmt_state *state, const char *str, size_t len);
+
+// internal itoa format: output everything that comes before the `len`
+// digits of a number (the padding, the sign, the '#' prefix and the
+// leading zeros), so that the digits may follow without having been
+// buffered up first
+//
+// \return How many of the leading digits to leave off; '#' may drop
+// some in order to fit the prefix in to the width.  state->width is
+// left as the count of spaces to append after the digits.
+PICO_FMT_API size_t _fmt_ntoa_format(struct fmt_state *state, size_t len, bool negative, unsigned int base);
+
+// internal itoa for 'long' type
+PICO_FMT_API void _fmt_ntoa_long(struct fmt_state *state, unsigned long value, bool negative, unsigned long base);
+
+// Parsing /////////////////////////////////////////////////////////////////////
+
+// the built-in conversions
+enum _fmt_conv {
+    CONV_NONE,   // not a built-in; the specifier character is printed as-is
+    CONV_SINT,   // %d %i
+    CONV_UINT,   // %u %x %X %o %b
+    CONV_DOUBLE, // %f %F %e %E %g %G
+    CONV_CHAR,   // %c
+    CONV_STR,    // %s
+    CONV_PTR,    // %p
+    CONV_PCT,    // %%
+    CONV_POS,    // the "$" of a "%N$" positional directive; else as CONV_NONE
+};
+
+// Set in state->flags by _fmt_parse_directive() for a "*" width or
+// precision; the caller fetches those arguments, and must clear these
+// before passing the state to a conversion.
+#define _FMT_FLAG_WIDTH_STAR FMT_SPEC_WIDTH_STAR
+#define _FMT_FLAG_PREC_STAR  FMT_SPEC_PREC_STAR
+
+/**
+ * Parse the directive starting just after the '%' at *format into
+ * state->{flags,width,precision,size,specifier}, leaving *format just
+ * past the specifier.
+ *
+ * \return the specifier's conversion, or -1 if the format string ends
+ * in the middle of the directive (leaving *format pointing at the
+ * terminating nul)
+ */
+PICO_FMT_API int _fmt_parse_directive(const char **format, struct fmt_state *state);
+
+static inline void _fmt_set_width(struct fmt_state *state, int w) {
+    if (w < 0) {
+        state->flags |= FMT_FLAG_LEFT;    // reverse padding
+        state->width = (unsigned int) -w;
+    } else {
+        state->width = (unsigned int) w;
+    }
+}
+
+static inline void _fmt_set_precision(struct fmt_state *state, int prec) {
+    state->precision = prec > 0 ? (unsigned int) prec : 0U;
+}
+
+// whether fmt_install() has installed a handler for character
+PICO_FMT_API bool _fmt_is_installed(char character);
+
+// Converting already-fetched values ///////////////////////////////////////////
+
+union _fmt_value {
+    long long            i; // CONV_SINT, CONV_CHAR
+    unsigned long long   u; // CONV_UINT
+    double               f; // CONV_DOUBLE
+    const char          *s; // CONV_STR
+    const void          *p; // CONV_PTR
+};
+
+/**
+ * Run the built-in conversion `conv` on a value that has already been
+ * fetched (rather than reading it from state->args).  Length modifiers
+ * are ignored; the value is printed as-is.
+ */
+PICO_FMT_API void _fmt_convert(struct fmt_state *state, enum _fmt_conv conv, union _fmt_value value);
+
+// Typed arguments /////////////////////////////////////////////////////////////
+
+// sizeof each of the integer types; 0 for the others
+static const uint8_t _fmt_type_size[] = {
+    [FMT_TYPE_INT]    = sizeof(int),
+    [FMT_TYPE_UINT]   = sizeof(unsigned int),
+    [FMT_TYPE_LONG]   = sizeof(long),
+    [FMT_TYPE_ULONG]  = sizeof(unsigned long),
+    [FMT_TYPE_LLONG]  = sizeof(long long),
+    [FMT_TYPE_ULLONG] = sizeof(unsigned long long),
+    [FMT_TYPE_INT8]   = sizeof(int8_t),
+    [FMT_TYPE_UINT8]  = sizeof(uint8_t),
+    [FMT_TYPE_INT16]  = sizeof(int16_t),
+    [FMT_TYPE_UINT16] = sizeof(uint16_t),
+    [FMT_TYPE_INT32]  = sizeof(int32_t),
+    [FMT_TYPE_UINT32] = sizeof(uint32_t),
+    [FMT_TYPE_INT64]  = sizeof(int64_t),
+    [FMT_TYPE_UINT64] = sizeof(uint64_t),
+    [FMT_TYPE_SIZE]   = sizeof(size_t),
+    [FMT_TYPE_CHAR]   = sizeof(char),
+    [FMT_TYPE_PTR]    = 0,
+};
+
+static inline bool _fmt_type_is_integer(enum fmt_type type) {
+    return type <= FMT_TYPE_CHAR;
+}
+
+static inline bool _fmt_type_is_signed(enum fmt_type type) {
+    switch (type) {
+        case FMT_TYPE_INT:
+        case FMT_TYPE_LONG:
+        case FMT_TYPE_LLONG:
+        case FMT_TYPE_INT8:
+        case FMT_TYPE_INT16:
+        case FMT_TYPE_INT32:
+        case FMT_TYPE_INT64:
+            return true;
+        case FMT_TYPE_CHAR:
+            return (char) -1 < 0;
+        default:
+            return false;
+    }
+}
+
+// Truncate v to size bytes, and then sign- or zero-extend it back out.
+static inline unsigned long long _fmt_extend(unsigned long long v, unsigned int size, bool sign) {
+    const unsigned int shift = 64U - 8U * size;
+    return sign ? (unsigned long long) ((long long) (v << shift) >> shift) : v << shift >> shift;
+}
+
+// The value of a `size`-byte integer argument (`sign`ed or not), for a
+// signed (`conv_sign`) or unsigned conversion.  It keeps its own value,
+// except that for an unsigned conversion a negative one wraps around
+// at its own width, as with the length modifier for its type.
+static inline unsigned long long _fmt_int_value(unsigned long long v, unsigned int size, bool sign, bool conv_sign) {
+    return _fmt_extend(v, size, sign && conv_sign);
+}
+
+// whether a value of `type` may be passed to the conversion `conv`
+PICO_FMT_API bool _fmt_type_suits(enum fmt_type type, enum _fmt_conv conv);
+
+// _fmt_convert() an argument that _fmt_type_suits() conv, converted
+// as printf would if given the argument's type
+PICO_FMT_API void _fmt_convert_arg(struct fmt_state *state, enum _fmt_conv conv, const struct fmt_arg *a);
+
+// Wrapper outputs /////////////////////////////////////////////////////////////
+//
+// The fmt_fct_t outputs that the buffer and sink variants of each
+// family of functions (convenience.c, format.c, ...) pass to its
+// fmt_fct_t variant.
+
+typedef struct {
+    char        *buffer;
+    size_t       maxlen;
+    size_t       cur;
+} _arg_buffer;
+
+static inline void _out_buffer(char character, void *_arg) {
+    _arg_buffer *arg = _arg;
+    if (arg->cur < arg->maxlen) {
+        arg->buffer[arg->cur++] = character;
+    }
+}
+
+struct fmt_sink;
+struct fmt_lock;
+
+// Stages the output in buf, handing it to sink each time that fills
+// (having first taken lock, if there is one); fmt_sink_write() the
+// last len bytes once done.
+struct _fmt_sink_stage {
+    struct fmt_sink         *sink;
+    const struct fmt_lock   *lock;
+    bool                     locked;
+    char                    *buf;
+    size_t                   cap;
+    size_t                   len;
+};
+
+// sink.c
+void _fmt_out_stage(char character, void *_arg);
+
+// Conversion families /////////////////////////////////////////////////////////
+//
+// printf.c has weak fallbacks for these that just print "??"; the real
+// ones only get linked in if their family's source file does.  (In the
+// single-header pico_fmt.h, the fallbacks are only there if the family
+// is configured out.)
+
+// %f %F %e %E %g %G; printf_float.c
+PICO_FMT_API void _fmt_dtoa(struct fmt_state *state, double value);
+
+#endif // _PICO_FMT_PRINTF_INTERNAL_H
@@ -0,0 +1,472 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <string.h> /* for memchr(), memcpy() */
+
+#include "pico/fmt_sink.h"
+#include "printf_internal.h"
+
+// Core API ////////////////////////////////////////////////////////////////////
+
+void fmt_sink_write(struct fmt_sink *sink, const char *buf, size_t len) {
+    if (len) {
+        sink->write(sink, buf, len);
+    }
+}
+
+void fmt_sink_flush(struct fmt_sink *sink) {
+    if (sink->flush) {
+        sink->flush(sink);
+    }
+}
+
+void _fmt_out_stage(char character, void *_arg) {
+    struct _fmt_sink_stage *stage = _arg;
+    stage->buf[stage->len++] = character;
+    if (stage->len == stage->cap) {
+        if (stage->lock && !stage->locked) {
+            stage->lock->acquire(stage->lock->arg);
+            stage->locked = true;
+        }
+        stage->sink->write(stage->sink, stage->buf, stage->len);
+        stage->len = 0;
+    }
+}
+
+int fmt_vsinkprintf(struct fmt_sink *sink, const char *format, va_list va) {
+    char buf[PICO_PRINTF_SINK_BUFFER_SIZE];
+    struct _fmt_sink_stage stage = {
+        .sink = sink,
+        .buf = buf,
+        .cap = sizeof(buf),
+        .len = 0,
+    };
+    const int ret = fmt_vfctprintf(_fmt_out_stage, &stage, format, va);
+    fmt_sink_write(sink, stage.buf, stage.len);
+    return ret;
+}
+
+int fmt_sinkprintf(struct fmt_sink *sink, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_vsinkprintf(sink, format, va);
+    va_end(va);
+    return ret;
+}
+
+int fmt_sinkprintf_args(struct fmt_sink *sink, const char *format, const struct fmt_arg *args, size_t n) {
+    char buf[PICO_PRINTF_SINK_BUFFER_SIZE];
+    struct _fmt_sink_stage stage = {
+        .sink = sink,
+        .buf = buf,
+        .cap = sizeof(buf),
+        .len = 0,
+    };
+    const int ret = fmt_fctprintf_args(_fmt_out_stage, &stage, format, args, n);
+    fmt_sink_write(sink, stage.buf, stage.len);
+    return ret;
+}
+
+// Format-then-lock ////////////////////////////////////////////////////////////
+
+int fmt_vsinkprintf_locked(struct fmt_sink *sink, const struct fmt_lock *lock,
+                           char *buf, size_t cap, const char *format, va_list va) {
+    char one;
+    if (!cap) {
+        // nowhere to stage it; hold the lock and write a character
+        // at a time
+        buf = &one;
+        cap = 1;
+    }
+    struct _fmt_sink_stage stage = {
+        .sink = sink,
+        .lock = lock,
+        .locked = false,
+        .buf = buf,
+        .cap = cap,
+        .len = 0,
+    };
+    const int ret = fmt_vfctprintf(_fmt_out_stage, &stage, format, va);
+    if (lock && !stage.locked) {
+        lock->acquire(lock->arg);
+    }
+    fmt_sink_write(sink, stage.buf, stage.len);
+    fmt_sink_flush(sink);
+    if (lock) {
+        lock->release(lock->arg);
+    }
+    return ret;
+}
+
+int fmt_sinkprintf_locked(struct fmt_sink *sink, const struct fmt_lock *lock,
+                          char *buf, size_t cap, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_vsinkprintf_locked(sink, lock, buf, cap, format, va);
+    va_end(va);
+    return ret;
+}
+
+// Terminal sinks //////////////////////////////////////////////////////////////
+
+static void _fct_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct fmt_sink_fct *self = (struct fmt_sink_fct *) _self;
+    for (size_t i = 0; i < len; i++) {
+        self->fct(buf[i], self->arg);
+    }
+}
+
+struct fmt_sink *fmt_sink_fct_init(struct fmt_sink_fct *s, fmt_fct_t fct, void *arg) {
+    *s = (struct fmt_sink_fct){
+        .sink = { .write = _fct_write },
+        .fct = fct,
+        .arg = arg,
+    };
+    return &s->sink;
+}
+
+static void _buf_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct fmt_sink_buf *self = (struct fmt_sink_buf *) _self;
+    if (self->cur >= self->maxlen) {
+        return;
+    }
+    if (len > self->maxlen - self->cur) {
+        len = self->maxlen - self->cur;
+    }
+    memcpy(&self->buffer[self->cur], buf, len);
+    self->cur += len;
+}
+
+struct fmt_sink *fmt_sink_buf_init(struct fmt_sink_buf *s, char *buffer, size_t maxlen) {
+    *s = (struct fmt_sink_buf){
+        .sink = { .write = _buf_write },
+        .buffer = buffer,
+        .maxlen = maxlen,
+        .cur = 0,
+    };
+    return &s->sink;
+}
+
+// Stages //////////////////////////////////////////////////////////////////////
+
+// tee
+
+static void _tee_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct fmt_sink_tee *self = (struct fmt_sink_tee *) _self;
+    for (size_t i = 0; i < self->n; i++) {
+        self->outs[i]->write(self->outs[i], buf, len);
+    }
+}
+
+static void _tee_flush(struct fmt_sink *_self) {
+    struct fmt_sink_tee *self = (struct fmt_sink_tee *) _self;
+    for (size_t i = 0; i < self->n; i++) {
+        fmt_sink_flush(self->outs[i]);
+    }
+}
+
+struct fmt_sink *fmt_sink_tee_init(struct fmt_sink_tee *s, struct fmt_sink **outs, size_t n) {
+    *s = (struct fmt_sink_tee){
+        .sink = { .write = _tee_write, .flush = _tee_flush },
+        .outs = outs,
+        .n = n,
+    };
+    return &s->sink;
+}
+
+// crc32
+
+// Half-byte tables keep these at 64 and 32 bytes of flash, rather than
+// the 1KiB and 512B of the usual full-byte tables.
+static const uint32_t crc32_table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+static void _crc32_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct fmt_sink_crc32 *self = (struct fmt_sink_crc32 *) _self;
+    uint32_t crc = self->crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint8_t) buf[i];
+        crc = (crc >> 4) ^ crc32_table[crc & 0xF];
+        crc = (crc >> 4) ^ crc32_table[crc & 0xF];
+    }
+    self->crc = crc;
+    self->next->write(self->next, buf, len);
+}
+
+static void _crc32_flush(struct fmt_sink *_self) {
+    struct fmt_sink_crc32 *self = (struct fmt_sink_crc32 *) _self;
+    if (self->append) {
+        const uint32_t crc = fmt_sink_crc32_value(self);
+        const char bytes[4] = {
+            (char) (crc >>  0), (char) (crc >>  8),
+            (char) (crc >> 16), (char) (crc >> 24),
+        };
+        self->next->write(self->next, bytes, sizeof(bytes));
+    }
+    self->crc = 0xFFFFFFFF;
+    fmt_sink_flush(self->next);
+}
+
+struct fmt_sink *fmt_sink_crc32_init(struct fmt_sink_crc32 *s, struct fmt_sink *next, bool append) {
+    *s = (struct fmt_sink_crc32){
+        .sink = { .write = _crc32_write, .flush = _crc32_flush },
+        .next = next,
+        .append = append,
+        .crc = 0xFFFFFFFF,
+    };
+    return &s->sink;
+}
+
+uint32_t fmt_sink_crc32_value(const struct fmt_sink_crc32 *s) {
+    return ~s->crc;
+}
+
+// crc16
+
+static const uint16_t crc16_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+static void _crc16_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct fmt_sink_crc16 *self = (struct fmt_sink_crc16 *) _self;
+    uint16_t crc = self->crc;
+    for (size_t i = 0; i < len; i++) {
+        const uint8_t byte = (uint8_t) buf[i];
+        crc = (uint16_t) ((crc << 4) ^ crc16_table[(crc >> 12) ^ (byte >> 4)]);
+        crc = (uint16_t) ((crc << 4) ^ crc16_table[(crc >> 12) ^ (byte & 0xF)]);
+    }
+    self->crc = crc;
+    self->next->write(self->next, buf, len);
+}
+
+static void _crc16_flush(struct fmt_sink *_self) {
+    struct fmt_sink_crc16 *self = (struct fmt_sink_crc16 *) _self;
+    if (self->append) {
+        const char bytes[2] = {
+            (char) (self->crc >> 8), (char) (self->crc >> 0),
+        };
+        self->next->write(self->next, bytes, sizeof(bytes));
+    }
+    self->crc = 0xFFFF;
+    fmt_sink_flush(self->next);
+}
+
+struct fmt_sink *fmt_sink_crc16_init(struct fmt_sink_crc16 *s, struct fmt_sink *next, bool append) {
+    *s = (struct fmt_sink_crc16){
+        .sink = { .write = _crc16_write, .flush = _crc16_flush },
+        .next = next,
+        .append = append,
+        .crc = 0xFFFF,
+    };
+    return &s->sink;
+}
+
+uint16_t fmt_sink_crc16_value(const struct fmt_sink_crc16 *s) {
+    return s->crc;
+}
+
+// cobs
+
+// block[0] is reserved for the code byte, so that a group goes out as
+// a single write.
+static void _cobs_emit(struct fmt_sink_cobs *self) {
+    self->block[0] = (char) (self->len + 1);
+    self->next->write(self->next, self->block, self->len + 1);
+    self->full = self->len == 254;
+    self->len = 0;
+}
+
+static void _cobs_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct fmt_sink_cobs *self = (struct fmt_sink_cobs *) _self;
+    while (len) {
+        const char *zero = memchr(buf, 0, len);
+        size_t run = zero ? (size_t) (zero - buf) : len;
+        while (run) {
+            size_t n = 254 - self->len;
+            if (n > run) {
+                n = run;
+            }
+            memcpy(&self->block[1 + self->len], buf, n);
+            self->len = (uint8_t) (self->len + n);
+            self->full = false;
+            buf += n;
+            len -= n;
+            run -= n;
+            if (self->len == 254) {
+                _cobs_emit(self);
+            }
+        }
+        if (zero) {
+            _cobs_emit(self);
+            self->full = false;
+            buf++;
+            len--;
+        }
+    }
+}
+
+static void _cobs_flush(struct fmt_sink *_self) {
+    struct fmt_sink_cobs *self = (struct fmt_sink_cobs *) _self;
+    // A full block carries no implied zero, so if one just went out
+    // there is nothing left to encode.
+    if (self->len || !self->full) {
+        _cobs_emit(self);
+    }
+    self->full = false;
+    self->next->write(self->next, "", 1);
+    fmt_sink_flush(self->next);
+}
+
+struct fmt_sink *fmt_sink_cobs_init(struct fmt_sink_cobs *s, struct fmt_sink *next) {
+    s->sink = (struct fmt_sink){ .write = _cobs_write, .flush = _cobs_flush };
+    s->next = next;
+    s->full = false;
+    s->len = 0;
+    return &s->sink;
+}
+
+// slip
+
+#define SLIP_END     '\xC0'
+#define SLIP_ESC     '\xDB'
+#define SLIP_ESC_END '\xDC'
+#define SLIP_ESC_ESC '\xDD'
+
+static const char slip_esc_end[2] = {SLIP_ESC, SLIP_ESC_END};
+static const char slip_esc_esc[2] = {SLIP_ESC, SLIP_ESC_ESC};
+
+static void _slip_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct fmt_sink_slip *self = (struct fmt_sink_slip *) _self;
+    size_t run = 0;
+    for (size_t i = 0; i < len; i++) {
+        const char *esc;
+        switch (buf[i]) {
+            case SLIP_END:
+                esc = slip_esc_end;
+                break;
+            case SLIP_ESC:
+                esc = slip_esc_esc;
+                break;
+            default:
+                continue;
+        }
+        fmt_sink_write(self->next, &buf[run], i - run);
+        self->next->write(self->next, esc, 2);
+        run = i + 1;
+    }
+    fmt_sink_write(self->next, &buf[run], len - run);
+}
+
+static void _slip_flush(struct fmt_sink *_self) {
+    struct fmt_sink_slip *self = (struct fmt_sink_slip *) _self;
+    self->next->write(self->next, (const char[]){SLIP_END}, 1);
+    fmt_sink_flush(self->next);
+}
+
+struct fmt_sink *fmt_sink_slip_init(struct fmt_sink_slip *s, struct fmt_sink *next) {
+    *s = (struct fmt_sink_slip){
+        .sink = { .write = _slip_write, .flush = _slip_flush },
+        .next = next,
+    };
+    return &s->sink;
+}
+
+// lines
+
+static void _lines_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct fmt_sink_lines *self = (struct fmt_sink_lines *) _self;
+    while (len) {
+        const char *nl = memchr(buf, '\n', len);
+        const size_t seg = nl ? (size_t) (nl - buf) + 1 : len;
+
+        if (!self->len && (nl || !self->cap)) {
+            // Fast path: a whole line with nothing pending (or no
+            // buffer to collect one in); pass it straight through
+            // without copying it, in the same cap-sized pieces.
+            size_t done = 0;
+            while (done < seg) {
+                size_t n = seg - done;
+                if (self->cap && n > self->cap) {
+                    n = self->cap;
+                }
+                self->next->write(self->next, &buf[done], n);
+                done += n;
+            }
+            if (nl) {
+                fmt_sink_flush(self->next);
+            }
+        } else {
+            size_t done = 0;
+            while (done < seg) {
+                size_t n = self->cap - self->len;
+                if (n > seg - done) {
+                    n = seg - done;
+                }
+                memcpy(&self->buf[self->len], &buf[done], n);
+                self->len += n;
+                done += n;
+                if (self->len == self->cap) {
+                    self->next->write(self->next, self->buf, self->len);
+                    self->len = 0;
+                }
+            }
+            if (nl) {
+                fmt_sink_write(self->next, self->buf, self->len);
+                self->len = 0;
+                fmt_sink_flush(self->next);
+            }
+        }
+        buf += seg;
+        len -= seg;
+    }
+}
+
+static void _lines_flush(struct fmt_sink *_self) {
+    struct fmt_sink_lines *self = (struct fmt_sink_lines *) _self;
+    fmt_sink_write(self->next, self->buf, self->len);
+    self->len = 0;
+    fmt_sink_flush(self->next);
+}
+
+struct fmt_sink *fmt_sink_lines_init(struct fmt_sink_lines *s, struct fmt_sink *next, char *buf, size_t cap) {
+    *s = (struct fmt_sink_lines){
+        .sink = { .write = _lines_write, .flush = _lines_flush },
+        .next = next,
+        .buf = buf,
+        .cap = cap,
+        .len = 0,
+    };
+    return &s->sink;
+}
+
+// limit
+
+static void _limit_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct fmt_sink_limit *self = (struct fmt_sink_limit *) _self;
+    size_t n = len < self->budget ? len : self->budget;
+    fmt_sink_write(self->next, buf, n);
+    self->budget -= n;
+    self->dropped += len - n;
+}
+
+static void _limit_flush(struct fmt_sink *_self) {
+    struct fmt_sink_limit *self = (struct fmt_sink_limit *) _self;
+    fmt_sink_flush(self->next);
+}
+
+struct fmt_sink *fmt_sink_limit_init(struct fmt_sink_limit *s, struct fmt_sink *next, size_t budget) {
+    *s = (struct fmt_sink_limit){
+        .sink = { .write = _limit_write, .flush = _limit_flush },
+        .next = next,
+        .budget = budget,
+        .dropped = 0,
+    };
+    return &s->sink;
+}
+
+void fmt_sink_limit_refill(struct fmt_sink_limit *s, size_t budget) {
+    s->budget = budget;
+}
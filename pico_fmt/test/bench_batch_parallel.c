@@ -0,0 +1,86 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// How fmt_batch_writev() scales from 1 thread to N.
+//
+// usage: bench_batch_parallel [NROWS [MAX_THREADS [OUTFILE]]]
+//
+// The output goes to /dev/null unless OUTFILE is given.
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pico/fmt_batch_parallel.h"
+
+struct sample {
+    uint32_t             ts;
+    int16_t              temp;
+    uint16_t             flags;
+    float                volts;
+    const char          *name;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    const size_t nrows = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    const long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const unsigned int max_threads = argc > 2 ? (unsigned int) strtoul(argv[2], NULL, 10) : (unsigned int) ncpus;
+    const int fd = open(argc > 3 ? argv[3] : "/dev/null", O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        perror("open");
+        return 1;
+    }
+
+    static const char *names[] = { "pump", "valve", "fan", "heater" };
+    struct sample *rows = malloc(nrows * sizeof(*rows));
+    if (!rows) {
+        perror("malloc");
+        return 1;
+    }
+    for (size_t i = 0; i < nrows; i++) {
+        rows[i] = (struct sample){
+            .ts = 1700000000U + (uint32_t) i,
+            .temp = (int16_t) ((i * 37) % 2000 - 1000),
+            .flags = (uint16_t) (i * 2654435761U),
+            .volts = (float) (i % 5000) / 1000.0f,
+            .name = names[i % 4],
+        };
+    }
+    const struct fmt_column cols[] = {
+        FMT_FIELD(FMT_TYPE_UINT32, rows, ts),
+        FMT_FIELD(FMT_TYPE_INT16, rows, temp),
+        FMT_FIELD(FMT_TYPE_UINT16, rows, flags),
+        FMT_FIELD(FMT_TYPE_FLOAT, rows, volts),
+        FMT_FIELD(FMT_TYPE_STR, rows, name),
+    };
+    const char *format = "%u,%d,0x%04x,%.3f,%s\n";
+
+    printf("%zu rows, %ld CPUs\n", nrows, ncpus);
+    printf("threads  seconds  Mrows/s  speedup\n");
+    double base = 0;
+    for (unsigned int n = 1; n <= max_threads; n++) {
+        const double start = now();
+        if (fmt_batch_writev(fd, n, format, cols, sizeof(cols)/sizeof(cols[0]), nrows) < 0) {
+            perror("fmt_batch_writev");
+            return 1;
+        }
+        const double secs = now() - start;
+        if (n == 1) {
+            base = secs;
+        }
+        printf("%7u  %7.3f  %7.2f  %6.2fx\n", n, secs, (double) nrows / secs / 1e6, base / secs);
+    }
+
+    free(rows);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// The cost of each format in a corpus of typical ones, for comparing
+// changes to the directive parser and conversions: the time per call
+// (the best of 21 runs), and optionally the instructions per call.
+//
+// Instructions are counted by single-stepping a child process that
+// runs the format 0 and then COUNT_ITERATIONS times, so the count
+// includes the call overhead but not the harness's; it works without
+// access to hardware performance counters (Linux only, and slow).
+//
+// usage: bench_directives [-i] [ITERATIONS]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <signal.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "pico/fmt_printf.h"
+
+#define TIME_RUNS        21
+#define COUNT_ITERATIONS 50
+
+static void _out_nop(char character, void *arg) {
+    (void) character;
+    (void) arg;
+}
+
+// Run corpus entry i n times, and return its format (or NULL if there
+// is no entry i).
+static const char *run(unsigned int i, unsigned long n) {
+#define B(idx, out, fmtstr, ...) case idx:                                          \
+        for (unsigned long k = 0; k < n; k++) {                                    \
+            fmt_fctprintf(out, NULL, fmtstr, __VA_ARGS__);                         \
+        }                                                                          \
+        return fmtstr
+    switch (i) {
+        // the parser: flags, widths, precisions and lengths, with a
+        // NULL output function
+        B(0,  NULL, "%d", 7);
+        B(1,  NULL, "%5d", 7);
+        B(2,  NULL, "%-+08.3ld", 7L);
+        B(3,  NULL, "%#010llx", 7ULL);
+        B(4,  NULL, "%*.*s", 6, 2, "ab");
+        B(5,  NULL, "%-5d", 7);
+        B(6,  NULL, "ts=%u lvl=%s msg=%.20s", 5U, "I", "hello");
+        B(7,  NULL, "%c%c%c%c%c%c", 'a', 'b', 'c', 'd', 'e', 'f');
+        B(8,  NULL, "%.3d", 7);
+        B(9,  NULL, "%08.3f", 3.14159);
+
+        // the fast paths for bare directives, and one that isn't, with
+        // an output function that does nothing
+        B(10, _out_nop, "%d", -12345);
+        B(11, _out_nop, "%u", 12345U);
+        B(12, _out_nop, "%x", 0xbeefU);
+        B(13, _out_nop, "%s", "hello");
+        B(14, _out_nop, "%c", 'x');
+        B(15, _out_nop, "id=%u temp=%d flags=%x name=%s", 42U, -7, 0x1fU, "pump");
+        B(16, _out_nop, "%5d", 12345);
+        default:
+            return NULL;
+    }
+#undef B
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static double time_per_call(unsigned int i, unsigned long n) {
+    double best = 0;
+    for (int r = 0; r < TIME_RUNS; r++) {
+        const double start = now();
+        run(i, n);
+        const double t = (now() - start) / (double) n;
+        if (!r || t < best) {
+            best = t;
+        }
+    }
+    return best * 1e9;
+}
+
+#ifdef __linux__
+// how many instructions the child executes between its SIGSTOP and its
+// exit, or -1
+static long count_instructions(unsigned int i, unsigned long n) {
+    const pid_t pid = fork();
+    if (pid < 0) {
+        return -1;
+    }
+    if (pid == 0) {
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+        raise(SIGSTOP);
+        run(i, n);
+        _exit(0);
+    }
+    int status;
+    long count = 0;
+    waitpid(pid, &status, 0);
+    while (WIFSTOPPED(status)) {
+        if (ptrace(PTRACE_SINGLESTEP, pid, NULL, NULL) < 0) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            return -1;
+        }
+        waitpid(pid, &status, 0);
+        count++;
+    }
+    return WIFEXITED(status) ? count : -1;
+}
+#endif
+
+int main(int argc, char **argv) {
+    int instructions = 0;
+    if (argc > 1 && strcmp(argv[1], "-i") == 0) {
+        instructions = 1;
+        argc--;
+        argv++;
+    }
+    const unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    printf("%-40s %8s %8s\n", "format", "instr", "ns");
+    const char *fmtstr;
+    for (unsigned int i = 0; (fmtstr = run(i, 0)); i++) {
+        long instr = -1;
+#ifdef __linux__
+        if (instructions) {
+            const long base = count_instructions(i, 0);
+            const long total = count_instructions(i, COUNT_ITERATIONS);
+            if (base >= 0 && total >= 0) {
+                instr = (total - base) / COUNT_ITERATIONS;
+            }
+        }
+#else
+        (void) instructions;
+#endif
+        char quoted[64];
+        snprintf(quoted, sizeof(quoted), "\"%s\"", fmtstr);
+        if (instr >= 0) {
+            printf("%-40s %8ld %8.1f\n", quoted, instr, time_per_call(i, n));
+        } else {
+            printf("%-40s %8s %8.1f\n", quoted, "-", time_per_call(i, n));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// How long the output lock is held per line, formatting with the lock
+// held (as pico_stdio's printf() does) versus with
+// fmt_sinkprintf_locked().  The stand-in for the stdio driver is a
+// mutex around a sink that copies in to a ring buffer in memory.
+//
+// usage: bench_lock_hold [NTHREADS [NLINES]]
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pico/fmt_sink.h"
+
+#define LINE_BUFFER_SIZE 128
+
+struct driver {
+    struct fmt_sink      sink;
+    pthread_mutex_t      mu;
+    char                 ring[4096];
+    size_t               pos;
+};
+
+struct worker {
+    pthread_t            thread;
+    struct driver       *drv;
+    bool                 locked;  // format-then-lock
+    unsigned long        nlines;
+    double               acquired;
+    double               held;    // total seconds the lock was held
+    unsigned long        nholds;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static void _driver_write(struct fmt_sink *self, const char *buf, size_t len) {
+    struct driver *drv = (struct driver *) self;
+    while (len) {
+        size_t n = sizeof(drv->ring) - drv->pos;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(&drv->ring[drv->pos], buf, n);
+        drv->pos = (drv->pos + n) % sizeof(drv->ring);
+        buf += n;
+        len -= n;
+    }
+}
+
+static void _acquire(void *arg) {
+    struct worker *w = arg;
+    pthread_mutex_lock(&w->drv->mu);
+    w->acquired = now();
+}
+
+static void _release(void *arg) {
+    struct worker *w = arg;
+    w->held += now() - w->acquired;
+    w->nholds++;
+    pthread_mutex_unlock(&w->drv->mu);
+}
+
+static void *_work(void *arg) {
+    struct worker *w = arg;
+    const struct fmt_lock lock = {
+        .acquire = _acquire,
+        .release = _release,
+        .arg = w,
+    };
+    for (unsigned long i = 0; i < w->nlines; i++) {
+#define LINE "[%8lu] %s: temp=%d flags=%#lx volts=%.3f\n", i, "pump", (int) (i % 200) - 100, (unsigned long) i * 7919UL, (double) i / 1000.0
+        if (w->locked) {
+            char buf[LINE_BUFFER_SIZE];
+            fmt_sinkprintf_locked(&w->drv->sink, &lock, buf, sizeof(buf), LINE);
+        } else {
+            _acquire(w);
+            fmt_sinkprintf(&w->drv->sink, LINE);
+            fmt_sink_flush(&w->drv->sink);
+            _release(w);
+        }
+#undef LINE
+    }
+    return NULL;
+}
+
+static int run(unsigned int nthreads, unsigned long nlines, bool locked) {
+    struct driver drv = {
+        .sink = { .write = _driver_write },
+    };
+    pthread_mutex_init(&drv.mu, NULL);
+    struct worker *workers = calloc(nthreads, sizeof(*workers));
+    if (!workers) {
+        perror("calloc");
+        return 1;
+    }
+    const double start = now();
+    for (unsigned int t = 0; t < nthreads; t++) {
+        workers[t] = (struct worker){
+            .drv = &drv,
+            .locked = locked,
+            .nlines = nlines,
+        };
+        if (pthread_create(&workers[t].thread, NULL, _work, &workers[t])) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+    double held = 0;
+    unsigned long nholds = 0;
+    for (unsigned int t = 0; t < nthreads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        held += workers[t].held;
+        nholds += workers[t].nholds;
+    }
+    const double elapsed = now() - start;
+    printf("%-18s %12.1f %12.1f\n",
+           locked ? "format-then-lock" : "lock-then-format",
+           held * 1e9 / (double) nholds,
+           elapsed * 1e9 / (double) (nlines * nthreads));
+    free(workers);
+    pthread_mutex_destroy(&drv.mu);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const unsigned int nthreads = argc > 1 ? (unsigned int) strtoul(argv[1], NULL, 10) : 4;
+    const unsigned long nlines = argc > 2 ? strtoul(argv[2], NULL, 10) : 200000;
+
+    printf("%u threads x %lu lines\n", nthreads, nlines);
+    printf("%-18s %12s %12s\n", "", "ns held/line", "ns/line");
+    if (run(nthreads, nlines, false) || run(nthreads, nlines, true)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// pico::fmt::snprintf() (formats parsed at compile time) against
+// fmt_snprintf() (parsed at run time, arguments through a va_list).
+//
+// usage: bench_printf_hpp [ITERATIONS]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "pico/fmt_printf.hpp"
+
+static volatile unsigned int sink;
+
+template <class F>
+static double ns_per_call(unsigned long n, F f) {
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < n; i++) {
+        sink += (unsigned int) f(i);
+    }
+    const std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - start;
+    return d.count() / (double) n;
+}
+
+#define BENCH(fmtstr, ...) do {                                                          \
+        const double c = ns_per_call(n, [&](unsigned long i) {                           \
+            (void) i;                                                                    \
+            return fmt_snprintf(buf, sizeof(buf), fmtstr, __VA_ARGS__);                 \
+        });                                                                              \
+        const double cxx = ns_per_call(n, [&](unsigned long i) {                         \
+            (void) i;                                                                    \
+            return pico::fmt::snprintf(buf, sizeof(buf), PICO_FMT(fmtstr), __VA_ARGS__); \
+        });                                                                              \
+        printf("%-40s %8.1f %8.1f %7.2fx\n", "\"" fmtstr "\"", c, cxx, c / cxx);         \
+    } while (0)
+
+int main(int argc, char **argv) {
+    const unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    char buf[128];
+
+    printf("%-40s %8s %8s %8s\n", "format", "C ns", "C++ ns", "speedup");
+    BENCH("%d", (int) i);
+    BENCH("%x", (unsigned int) i);
+    BENCH("%s", "hello");
+    BENCH("id=%u temp=%d flags=%x name=%s", (unsigned int) i, -7, 0x1fU, "pump");
+    BENCH("[%8d|%-6s|%08x]", (int) i, "ab", (unsigned int) i);
+    BENCH("%ld %llu", (long) i, (unsigned long long) i * 1000003ULL);
+    BENCH("%.3f", (double) i / 7.0);
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// fmt_snprintf() from the pico_fmt library, or (built as
+// bench_snprintf_single) from the single-header pico_fmt.h; run both
+// and compare.
+//
+// usage: bench_snprintf [ITERATIONS]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if PICO_FMT_BENCH_SINGLE
+#include "pico_fmt.h"
+#define LIB "pico_fmt.h"
+#else
+#include "pico/fmt_printf.h"
+#define LIB "pico_fmt"
+#endif
+
+static volatile unsigned int sink;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+#define BENCH(want, fmtstr, ...) do {                                              \
+        fmt_snprintf(buf, sizeof(buf), fmtstr, __VA_ARGS__);                       \
+        if (strcmp(buf, want) != 0) {                                              \
+            printf("%s: got \"%s\", want \"%s\"\n", fmtstr, buf, want);            \
+            return 1;                                                              \
+        }                                                                          \
+        const double start = now();                                                \
+        for (unsigned long i = 0; i < n; i++) {                                    \
+            sink += (unsigned int) fmt_snprintf(buf, sizeof(buf), fmtstr, __VA_ARGS__); \
+        }                                                                          \
+        printf("%-40s %8.1f\n", "\"" fmtstr "\"", (now() - start) * 1e9 / (double) n); \
+    } while (0)
+
+int main(int argc, char **argv) {
+    const unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    char buf[128];
+
+    printf("%-40s %8s\n", "format (" LIB ")", "ns");
+    BENCH("-12345", "%d", -12345);
+    BENCH("beef", "%x", 0xbeefU);
+    BENCH("hello", "%s", "hello");
+    BENCH("id=42 temp=-7 flags=1f name=pump", "id=%u temp=%d flags=%x name=%s", 42U, -7, 0x1fU, "pump");
+    BENCH("[   12345|ab    |0000beef]", "[%8d|%-6s|%08x]", 12345, "ab", 0xbeefU);
+    BENCH("a fairly long literal with just one 7 in it", "a fairly long literal with just one %d in it", 7);
+    BENCH("3.142", "%.3f", 3.14159);
+    return 0;
+}
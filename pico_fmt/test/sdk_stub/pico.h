@@ -0,0 +1,15 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Just enough of pico-sdk's "pico.h" to build pico_printf on the host,
+// for test_printf_inline.c.
+
+#ifndef _PICO_H
+#define _PICO_H
+
+#include <stdbool.h>
+
+#define __printflike(a, b) __attribute__((format(printf, a, b)))
+#define WRAPPER_FUNC(x) __wrap_ ## x
+
+#endif
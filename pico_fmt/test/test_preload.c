@@ -0,0 +1,128 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// libpicofmt.so must stand in for libc's printf family without
+// changing any program's output.  Built twice: linked with
+// libpicofmt.so (test_preload), and not (test_preload_ld, run with it
+// in LD_PRELOAD).  Either way, snprintf() et al. here are
+// libpicofmt.so's, and are checked against libc's own.
+
+#define _GNU_SOURCE
+#undef _FORTIFY_SOURCE
+
+#include <dlfcn.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+static unsigned int failures = 0;
+
+static int (*libc_vsnprintf)(char *, size_t, const char *, va_list);
+
+static int libc_snprintf(char *buffer, size_t count, const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = libc_vsnprintf(buffer, count, format, va);
+    va_end(va);
+    return ret;
+}
+
+#define CHECK(fmtstr, ...) do {                                                      \
+        char want[200], got[200];                                                    \
+        const int want_n = libc_snprintf(want, sizeof(want), fmtstr, __VA_ARGS__);   \
+        const int got_n = snprintf(got, sizeof(got), fmtstr, __VA_ARGS__);           \
+        if (got_n != want_n || strcmp(want, got)) {                                  \
+            printf("failure: %s:%u: %s: want %d \"%s\", got %d \"%s\"\n",            \
+                   __FILE__, __LINE__, fmtstr, want_n, want, got_n, got);            \
+            failures++;                                                              \
+        }                                                                            \
+    } while (0)
+
+int main(void) {
+    void *libc = dlopen("libc.so.6", RTLD_LAZY | RTLD_NOLOAD);
+    libc_vsnprintf = libc ? dlsym(libc, "vsnprintf") : NULL;
+    if (!libc_vsnprintf) {
+        printf("failure: %s:%u: can't find libc's vsnprintf\n", __FILE__, __LINE__);
+        return 1;
+    }
+    if ((void *) &snprintf == dlsym(libc, "snprintf") || (void *) &vsnprintf == (void *) libc_vsnprintf) {
+        printf("failure: %s:%u: snprintf() isn't interposed\n", __FILE__, __LINE__);
+        return 1;
+    }
+
+    // (some of these are deliberately not standard C, to check that
+    // they are left to libc, and some deliberately truncate)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#pragma GCC diagnostic ignored "-Wformat-overflow"
+
+    // formatted by pico_fmt
+    CHECK("%d", -12345);
+    CHECK("%i|%u|%x|%X|%o", 42, 42U, 0xbeefU, 0xbeefU, 8U);
+    CHECK("[%5d] [%-5d] [%05d] [%+d] [% d] [%.3d] [%08.3d]", 42, 42, -42, 42, 42, 7, -7);
+    CHECK("[%*d] [%-*d] [%.*d]", 6, 1, -6, 2, 4, 3);
+    CHECK("%hhd %hd %ld %lld %zu %td %jd", 300, 70000, -1L, -1LL, (size_t) -1, (ptrdiff_t) -5, (intmax_t) 9);
+    CHECK("[%c] [%3c] [%-3c]", 'a', 'b', 'c');
+    CHECK("[%s] [%8s] [%-8s] [%.2s] [%.*s]", "abc", "abc", "abc", "abc", 1, "abc");
+    CHECK("100%% %s", "done");
+    CHECK("[%.0d] [%5.0x]", 0, 0U);
+    CHECK("[%.40d] [%040d] [%0100lld]", 5, 5, 5LL);
+
+    // passed on to libc
+    CHECK("%p", (void *) &failures);
+    CHECK("%f %e %g %a", 3.14159, 31415.9, 0.0001, 1.0);
+    CHECK("[%#x] [%#o] [%#1x] [%#.o]", 255U, 8U, 1U, 0U);
+    CHECK("[%-.3d] [%-5.3d]", 7, 7);
+    CHECK("[%.*d] [%.*s]", -1, 0, -2, "abc");
+    CHECK("[%s]", (char *) NULL);
+    CHECK("%2$s %1$s", "a", "b");
+    CHECK("[%ls] [%lc]", L"wide", (wint_t) L'c');
+    CHECK("%'d", 1234567);
+    CHECK("[%5%]", 0);
+
+    // truncation
+    char buf[8];
+    memset(buf, 'x', sizeof(buf));
+    if (snprintf(buf, 4, "ab%dcd", 123) != 7 || strcmp(buf, "ab1") || buf[4] != 'x') {
+        printf("failure: %s:%u: truncation\n", __FILE__, __LINE__);
+        failures++;
+    }
+#pragma GCC diagnostic pop
+    if (sprintf(buf, "%s-%d", "ab", 12) != 5 || strcmp(buf, "ab-12")) {
+        printf("failure: %s:%u: sprintf\n", __FILE__, __LINE__);
+        failures++;
+    }
+    int n = -1;
+    if (snprintf(buf, sizeof(buf), "ab%ncd", &n) != 4 || n != 2) {
+        printf("failure: %s:%u: %%n\n", __FILE__, __LINE__);
+        failures++;
+    }
+
+#if PICO_FMT_PRELOAD_STDIO
+    // ordered with the rest of stdio
+    FILE *f = tmpfile();
+    fputs("a", f);
+    fprintf(f, "[%d|%s]", 42, "pico");
+    fputc('b', f);
+    fprintf(f, "[%.1f]", 2.5);
+    fputs("c", f);
+    char line[64] = {0};
+    rewind(f);
+    if (!fgets(line, sizeof(line), f) || strcmp(line, "a[42|pico]b[2.5]c")) {
+        printf("failure: %s:%u: fprintf: got \"%s\"\n", __FILE__, __LINE__, line);
+        failures++;
+    }
+    fclose(f);
+#endif
+
+    if (failures) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// pico::fmt (<pico/fmt_printf.hpp>) must write exactly what
+// fmt_snprintf() does for the same format.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "pico/fmt_printf.hpp"
+
+static unsigned int failures = 0;
+
+#define CHECK(fmtstr, ...) do {                                                      \
+        char want[100], got[100];                                                    \
+        const int want_n = fmt_snprintf(want, sizeof(want), fmtstr, __VA_ARGS__);    \
+        const int got_n = pico::fmt::snprintf(got, sizeof(got), PICO_FMT(fmtstr), __VA_ARGS__); \
+        if (want_n != got_n || strcmp(want, got)) {                                  \
+            printf("failure: %s:%u: %s: want %d \"%s\", got %d \"%s\"\n",            \
+                   __FILE__, __LINE__, fmtstr, want_n, want, got_n, got);            \
+            failures++;                                                              \
+        }                                                                            \
+    } while (0)
+
+enum class color : uint8_t { red = 1, green = 2 };
+
+int main() {
+    CHECK("%d", -12345);
+    CHECK("%i|%u|%x|%X|%o|%b", 42, 42U, 0xbeefU, 0xbeefU, 8U, 5U);
+    CHECK("[%5d] [%-5d] [%05d] [%+d] [% d]", 42, 42, -42, 42, 42);
+    CHECK("%.3d|%#x|%#o", 7, 255U, 8U);
+    CHECK("%*d|%-*d|%.*s", 6, 1, 4, 2, 2, "abc");
+    CHECK("%s|%10s|%-10s|%.2s", "str", "right", "left", "trunc");
+    CHECK("%c%c%%", 'o', 'k');
+    CHECK("%ld %lld %lu %zu", -1234567890L, -1234567890123LL, 4000000000UL, sizeof(long));
+    CHECK("%hhu %hd", (unsigned char) 200, (short) -5);
+    CHECK("%d %u", (int8_t) -1, (uint16_t) 65535);
+    CHECK("%f|%.2f|%8.3f|%-8.1f|", 3.25, -2.5, 1.0 / 3.0, 2.0);
+    CHECK("%.1f", 0.5f);
+    CHECK("no directives%s", "");
+
+    char buf[32];
+    char name[] = "pump";
+    if (pico::fmt::snprintf(buf, sizeof(buf), PICO_FMT("%d %s"), color::green, name) != 6 || strcmp(buf, "2 pump")) {
+        printf("failure: %s:%u: enum and char[]\n", __FILE__, __LINE__);
+        failures++;
+    }
+    if (pico::fmt::snprintf(buf, 4, PICO_FMT("%s"), "truncated") != 9 || strcmp(buf, "tru")) {
+        printf("failure: %s:%u: truncation\n", __FILE__, __LINE__);
+        failures++;
+    }
+    if (pico::fmt::snprintf(buf, sizeof(buf), PICO_FMT("%p"), nullptr) != (int) (2 * sizeof(void *))) {
+        printf("failure: %s:%u: %%p\n", __FILE__, __LINE__);
+        failures++;
+    }
+
+    // the worst case is known at compile time
+    static_assert(pico::fmt::maxlen<int>(PICO_FMT("%d")) == 11);
+    static_assert(pico::fmt::maxlen<int8_t, uint64_t>(PICO_FMT("%d|%llx")) == 4 + 1 + 16);
+    static_assert(pico::fmt::maxlen<const char *, double>(PICO_FMT("%.4s=%.3e")) == 4 + 1 + 12);
+    static_assert(pico::fmt::maxlen<const char *>(PICO_FMT("%s")) == FMT_MAXLEN_UNBOUNDED);
+    char exact[pico::fmt::maxlen<int16_t, unsigned char>(PICO_FMT("%d:%u")) + 1];
+    if (pico::fmt::sprintf(exact, PICO_FMT("%d:%u"), (int16_t) INT16_MIN, (unsigned char) 255) != 10
+        || strcmp(exact, "-32768:255")) {
+        printf("failure: %s:%u: sprintf: got \"%s\"\n", __FILE__, __LINE__, exact);
+        failures++;
+    }
+
+    if (failures) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("success!\n");
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// <pico/printf.h> with PICO_PRINTF_INLINE_CONST_FORMATS: each of the
+// ways that a sprintf()/snprintf() call may be resolved must print
+// what printf would have (and, being built with -Werror=format, the
+// calls must still have their arguments checked against the format).
+
+#include <string.h>
+
+#include "pico/printf.h"
+
+static unsigned int failures = 0;
+
+#define CHECK(want_n, want, got_n, got) do {                                         \
+        if ((got_n) != (want_n) || strcmp(want, got)) {                              \
+            printf("failure: %s:%u: want %d \"%s\", got %d \"%s\"\n",               \
+                   __FILE__, __LINE__, want_n, want, got_n, got);                    \
+            failures++;                                                              \
+        }                                                                            \
+    } while (0)
+
+int main(void) {
+    char buf[8];
+    int n;
+
+    // literal text only
+    n = snprintf(buf, sizeof(buf), "abc");
+    CHECK(3, "abc", n, buf);
+    n = snprintf(buf, 3, "abcdef");
+    CHECK(6, "ab", n, buf);
+    n = sprintf(buf, "100%%");
+    CHECK(4, "100%", n, buf);
+    n = sprintf(buf, "0123456789");
+    CHECK(10, "0123456", n, buf);
+
+    // "%s" and "%d"
+    n = snprintf(buf, sizeof(buf), "%s", "pump");
+    CHECK(4, "pump", n, buf);
+    n = snprintf(buf, 3, "%s", "pump");
+    CHECK(4, "pu", n, buf);
+    n = sprintf(buf, "%s", "0123456789");
+    CHECK(10, "0123456", n, buf);
+    n = snprintf(buf, sizeof(buf), "%d", -2147483647 - 1);
+    CHECK(11, "-214748", n, buf);
+    n = sprintf(buf, "%d", 0);
+    CHECK(1, "0", n, buf);
+    n = sprintf(buf, "%d", -42);
+    CHECK(3, "-42", n, buf);
+
+    // anything else
+    n = snprintf(buf, sizeof(buf), "%x|%s", 255U, "ab");
+    CHECK(5, "ff|ab", n, buf);
+    n = sprintf(buf, "%5d", 42);
+    CHECK(5, "   42", n, buf);
+    const char *volatile fmtstr = "%s";
+    n = snprintf(buf, sizeof(buf), fmtstr, "xyz");
+    CHECK(3, "xyz", n, buf);
+
+    if (failures) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Copyright (C) 2025  Luke T. Shumaker <lukeshu@lukeshu.com>
+// SPDX-License-Identifier: BSD-3-Clause
+
+// The single-header pico_fmt.h must write what the library does; in
+// particular, its fmt_snprintf() writes straight in to the buffer.
+
+#include <stdio.h>
+#include <string.h>
+
+#if PICO_FMT_TEST_BAD_INCLUDE_ORDER
+// must not compile (see CMakeLists.txt)
+#include "pico/fmt_sink.h"
+#endif
+
+#include "pico_fmt.h"
+
+// (after pico_fmt.h, they are already covered by it)
+#include "pico/fmt_printf.h"
+#include "pico/fmt_maxlen.h"
+
+static unsigned int failures = 0;
+
+#define CHECK(want, fmtstr, ...) do {                                                \
+        char got[100];                                                               \
+        const int got_n = fmt_snprintf(got, sizeof(got), fmtstr, __VA_ARGS__);       \
+        if (got_n != (int) strlen(want) || strcmp(want, got)) {                      \
+            printf("failure: %s:%u: %s: want \"%s\", got %d \"%s\"\n",               \
+                   __FILE__, __LINE__, fmtstr, want, got_n, got);                    \
+            failures++;                                                              \
+        }                                                                            \
+    } while (0)
+
+static void conv_upper(struct fmt_state *state) {
+    for (const char *s = fmt_conv_arg(state, FMT_TYPE_STR).s; *s; s++) {
+        fmt_conv_putchar(state, (char) (*s >= 'a' && *s <= 'z' ? *s - 'a' + 'A' : *s));
+    }
+}
+
+static void out_count(char character, void *arg) {
+    (void) character;
+    (*(unsigned int *) arg)++;
+}
+
+int main(void) {
+    CHECK("-12345", "%d", -12345);
+    CHECK("42|42|beef|BEEF|10|101", "%i|%u|%x|%X|%o|%b", 42, 42U, 0xbeefU, 0xbeefU, 8U, 5U);
+    CHECK("[   42] [42   ] [-0042] [+42]", "[%5d] [%-5d] [%05d] [%+d]", 42, 42, -42, 42);
+    CHECK("id=42 temp=-7 flags=1f name=pump", "id=%u temp=%d flags=%x name=%s", 42U, -7, 0x1fU, "pump");
+    CHECK("literal text only", "literal text only%s", "");
+    CHECK("100%", "%d%%", 100);
+    CHECK("b a", "%2$s %1$s", "a", "b");
+#if PICO_PRINTF_SUPPORT_FLOAT
+    CHECK("3.142", "%.3f", 3.14159);
+#endif
+
+    char buf[8];
+    memset(buf, 'x', sizeof(buf));
+    if (fmt_snprintf(buf, 4, "ab%dcd", 123) != 7 || strcmp(buf, "ab1") || buf[4] != 'x') {
+        printf("failure: %s:%u: truncation\n", __FILE__, __LINE__);
+        failures++;
+    }
+    buf[0] = 'x';
+    if (fmt_snprintf(buf, 0, "abc") != 3 || buf[0] != 'x') {
+        printf("failure: %s:%u: count=0\n", __FILE__, __LINE__);
+        failures++;
+    }
+    if (fmt_snprintf(NULL, 0, "%s-%d", "abc", 1) != 5) {
+        printf("failure: %s:%u: NULL buffer\n", __FILE__, __LINE__);
+        failures++;
+    }
+    unsigned int n = 0;
+    if (fmt_fctprintf(out_count, &n, "%s=%d", "abc", 10) != 6 || n != 6) {
+        printf("failure: %s:%u: fmt_fctprintf\n", __FILE__, __LINE__);
+        failures++;
+    }
+
+    if (!fmt_install_conv('U', conv_upper)) {
+        printf("failure: %s:%u: fmt_install_conv\n", __FILE__, __LINE__);
+        failures++;
+    }
+    CHECK("<PUMP>", "<%U>", "pump");
+
+    if (failures) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -35,12 +35,26 @@
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <limits.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "pico/fmt_printf.h"
+#include "pico/fmt_install.h"
+#include "pico/fmt_sink.h"
+#include "pico/fmt_batch.h"
+#include "pico/fmt_format.h"
+#include "pico/fmt_generic.h"
+#include "pico/fmt_maxlen.h"
+#if LIB_PICO_FMT_PARALLEL
+#include "pico/fmt_batch_parallel.h"
+#endif
+#if PICO_FMT_TEST_CODEGEN
+#include "fmt_codegen_test.h"
+#endif
 
 static char   printf_buffer[100];
 static size_t printf_idx = 0U;
@@ -114,6 +128,97 @@ static void vsnprintf_builder_3(char* buffer, ...)
     va_end(args);
 }
 
+struct _test_locked_sink {
+    struct fmt_sink  sink;
+    struct fmt_sink *next;
+    bool             locked;
+    unsigned int     acquires;
+    unsigned int     writes;
+    unsigned int     unlocked_writes;
+};
+
+static void _test_lock_acquire(void *arg) {
+    struct _test_locked_sink *s = arg;
+    s->locked = true;
+    s->acquires++;
+}
+
+static void _test_lock_release(void *arg) {
+    struct _test_locked_sink *s = arg;
+    s->locked = false;
+}
+
+static void _test_locked_write(struct fmt_sink *_self, const char *buf, size_t len) {
+    struct _test_locked_sink *self = (struct _test_locked_sink *) _self;
+    self->writes++;
+    if (!self->locked)
+        self->unlocked_writes++;
+    fmt_sink_write(self->next, buf, len);
+}
+
+static void _test_conv_legacy(struct fmt_state state) {
+    const char *s = va_arg(*state.args, const char *);
+    fmt_state_putchar(state, '<');
+    while (*s)
+        fmt_state_putchar(state, *(s++));
+    fmt_state_putchar(state, '0' + (char) (fmt_state_len(state) % 10));
+    fmt_state_putchar(state, '>');
+}
+
+static void _test_conv_arg(struct fmt_state *state) {
+    const int v = fmt_conv_arg(state, FMT_TYPE_INT16).i;
+    fmt_conv_putchar(state, '{');
+    fmt_conv_putchar(state, v < 0 ? '-' : '+');
+    fmt_conv_putchar(state, '}');
+}
+
+static void _test_conv(struct fmt_state *state) {
+    const char *s = va_arg(*state->args, const char *);
+    fmt_conv_putchar(state, '[');
+    if (state->flags & FMT_FLAG_HASH)
+        fmt_conv_putchar(state, '#');
+    while (*s)
+        fmt_conv_putchar(state, *(s++));
+    fmt_conv_putchar(state, '0' + (char) (fmt_conv_len(state) % 10));
+    fmt_conv_putchar(state, ']');
+}
+
+// a "struct" of an int16 and a string, with the string through 'W'
+static void _test_conv_nested(struct fmt_state *state) {
+    const int v = fmt_conv_arg(state, FMT_TYPE_INT16).i;
+    const int n = fmt_conv_printf(state, "(%d,%W)", v, "s");
+    fmt_conv_putchar(state, '0' + (char) (n % 10));
+    fmt_conv_putchar(state, '0' + (char) (fmt_conv_len(state) % 10));
+}
+
+// the number under the directive's flags, and then with flags of its own
+static void _test_conv_toolkit(struct fmt_state *state) {
+    const long long v = fmt_conv_arg(state, FMT_TYPE_LLONG).i;
+    struct fmt_state field = *state;
+    fmt_conv_write(state, "<>", 1);
+    fmt_conv_int(state, v, 'd');
+    fmt_conv_pad(state, '.', 2);
+    field.flags = FMT_FLAG_HASH;
+    field.width = 0;
+    fmt_conv_uint(&field, (unsigned long long) v, 'X');
+    fmt_conv_write(state, "<>" + 1, 1);
+}
+
+#if PICO_PRINTF_SUPPORT_FLOAT
+// eighths, to two decimal places
+static void _test_conv_toolkit_double(struct fmt_state *state) {
+    const int v = fmt_conv_arg(state, FMT_TYPE_INT).i;
+    state->flags |= FMT_FLAG_PRECISION;
+    state->precision = 2;
+    fmt_conv_double(state, (double) v / 8, 'f');
+}
+#endif
+
+static void _count_fct(char character, void *arg) {
+    (void) character;
+    (*(size_t *) arg)++;
+}
+
 int main()
 {
     const char *grp_name;
@@ -501,6 +606,33 @@ int main()
     }
 
 
+    TEST_CASE("bare directives", "[]" );
+    {
+        char buffer[100];
+
+        fmt_sprintf(buffer, "%d %i %u %x %X %c %s", -2147483647 - 1, 0, 4294967295U, 0xbeefU, 0xbeefU, 'z', "ok");
+        REQUIRE_STREQ(buffer, "-2147483648 0 4294967295 beef BEEF z ok");
+
+        REQUIRE(fmt_snprintf(buffer, 4, "%s|%d", "abcdef", -12) == 10);
+        REQUIRE_STREQ(buffer, "abc");
+    }
+
+
+    TEST_CASE("truncated directive", "[]" );
+    {
+        char buffer[100];
+
+        REQUIRE(fmt_sprintf(buffer, "abc%") == 3);
+        REQUIRE_STREQ(buffer, "abc");
+
+        REQUIRE(fmt_sprintf(buffer, "abc%-08.3") == 3);
+        REQUIRE_STREQ(buffer, "abc");
+
+        REQUIRE(fmt_sprintf(buffer, "abc%ll") == 3);
+        REQUIRE_STREQ(buffer, "abc");
+    }
+
+
     TEST_CASE("width", "[]" );
     {
         char buffer[100];
@@ -1000,6 +1132,37 @@ int main()
     }
 
 
+    TEST_CASE("padding 40", "[]" );
+    {
+        char buffer[100];
+
+        fmt_sprintf(buffer, "%040d", -1024);
+        REQUIRE_STREQ(buffer, "-000000000000000000000000000000000001024");
+
+        fmt_sprintf(buffer, "%-40d|", 1024);
+        REQUIRE_STREQ(buffer, "1024                                    |");
+
+        fmt_sprintf(buffer, "%.40x", 48879U);
+        REQUIRE_STREQ(buffer, "000000000000000000000000000000000000beef");
+
+        fmt_sprintf(buffer, "%60.50o", 8U);
+        REQUIRE_STREQ(buffer, "          00000000000000000000000000000000000000000000000010");
+
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+        fmt_sprintf(buffer, "%+070lld", 123456789012345678LL);
+        REQUIRE_STREQ(buffer, "+000000000000000000000000000000000000000000000000000123456789012345678");
+#endif
+
+#if PICO_PRINTF_SUPPORT_FLOAT
+        fmt_sprintf(buffer, "%.30f", 1.5);
+        REQUIRE_STREQ(buffer, "1.500000000000000000000000000000");
+
+        fmt_sprintf(buffer, "%050.3f", -2.5);
+        REQUIRE_STREQ(buffer, "-000000000000000000000000000000000000000000002.500");
+#endif
+    }
+
+
 #if PICO_PRINTF_SUPPORT_FLOAT
     TEST_CASE("float padding neg numbers", "[]" );
     {
@@ -1502,6 +1665,11 @@ int main()
 
         fmt_sprintf(buffer, "%.*s", 3, "123456");
         REQUIRE_STREQ(buffer, "123");
+
+        // not read past the precision
+        const char unterminated[4] = {'t', 'e', 's', 't'};
+        fmt_sprintf(buffer, "%.4s|%.0s|%-3.1s|", unterminated, unterminated, unterminated);
+        REQUIRE_STREQ(buffer, "test||t  |");
     }
 
 
@@ -1594,6 +1762,851 @@ int main()
 #endif
     }
 
+    TEST_CASE("install", "[]" );
+    {
+        char buffer[100];
+
+        fmt_install('Q', _test_conv_legacy);
+        fmt_install_conv('W', _test_conv);
+
+        fmt_sprintf(buffer, "%d%Q%#W%d", 1, "ab", "cd", 2);
+        REQUIRE_STREQ(buffer, "1<ab4>[#cd0]2");
+
+        // re-installing switches between the two ABIs
+        fmt_install_conv('Q', _test_conv);
+        fmt_install('W', _test_conv_legacy);
+        fmt_sprintf(buffer, "%Q%W", "ab", "cd");
+        REQUIRE_STREQ(buffer, "[ab3]<cd8>");
+
+        // nested formatting, in to the same output
+        fmt_install_conv('Q', _test_conv_nested);
+        fmt_sprintf(buffer, "ab%Qcd", 12);
+        REQUIRE_STREQ(buffer, "ab(12,<s8>)92cd");
+        REQUIRE(fmt_snprintf(buffer, 6, "ab%Qcd", 12) == 15);
+        REQUIRE_STREQ(buffer, "ab(12");
+        printf_idx = 0U;
+        fmt_fctprintf(_out_fct, NULL, "%d%Q", 7, -3);
+        printf_buffer[printf_idx] = '\0';
+        REQUIRE_STREQ(printf_buffer, "7(-3,<s7>)91");
+        {
+            // the enclosing arguments are an array, the nested ones aren't
+            const struct fmt_arg args[] = { FMT_ARG_INT(5), FMT_ARG_INT(6) };
+            fmt_snprintf_args(buffer, sizeof(buffer), "%Q%d", args, 2);
+            REQUIRE_STREQ(buffer, "(5,<s5>)896");
+        }
+        // padded as a whole, like "%s"
+        fmt_sprintf(buffer, "|%12Q|%-12Q|", 1, 2);
+        REQUIRE_STREQ(buffer, "|    (1,<s0>)24|(2,<s1>)    29|");
+        fmt_sprintf(buffer, "|%2Q|", 1);
+        REQUIRE_STREQ(buffer, "|(1,<s6>)80|");
+        // (with spaces, even with '0')
+        fmt_sprintf(buffer, "|%012Q|", 1);
+        REQUIRE_STREQ(buffer, "|    (1,<s0>)24|");
+        {
+            // and it counts towards the limits' max_output
+            const struct fmt_limits limits = {
+                .max_output = 6,
+                .max_width = 20,
+                .max_precision = 20,
+                .max_directives = 4,
+            };
+            REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "ab%Qcd", 12) == FMT_LIMITED);
+            REQUIRE_STREQ(buffer, "ab(12,");
+        }
+
+        // the conversion toolkit
+        fmt_install_conv('Q', _test_conv_toolkit);
+        fmt_sprintf(buffer, "%Q|%+6Q|%-4Q|", 0LL, 42LL, -3LL);
+        REQUIRE_STREQ(buffer, "<0..0>|<   +42..0X2A>|<-3  ..0XFFFFFFFFFFFFFFFD>|");
+        printf_idx = 0U;
+        fmt_fctprintf(_out_fct, NULL, "%05Q", 20LL);
+        printf_buffer[printf_idx] = '\0';
+        REQUIRE_STREQ(printf_buffer, "<00020..0X14>");
+        REQUIRE(fmt_snprintf(buffer, 4, "ab%Q", 7LL) == 10);
+        REQUIRE_STREQ(buffer, "ab<");
+#if PICO_PRINTF_SUPPORT_FLOAT
+        fmt_install_conv('Q', _test_conv_toolkit_double);
+        fmt_sprintf(buffer, "%Q|%+7Q|%-6Q|", 1, 42, -3);
+        REQUIRE_STREQ(buffer, "0.12|  +5.25|-0.38 |");
+#endif
+
+        fmt_install_conv('Q', NULL);
+        fmt_install_conv('W', NULL);
+        fmt_sprintf(buffer, "%Q%W");
+        REQUIRE_STREQ(buffer, "QW");
+    }
+
+
+    TEST_CASE("locale", "[]" );
+    {
+        static struct fmt_locale a, b;
+        char buffer[100];
+
+        fmt_locale_init(&a);
+        fmt_locale_install_conv(&a, 'Q', _test_conv);
+        fmt_locale_install(&b, 'Q', _test_conv_legacy);
+        fmt_locale_install_conv(&b, 'd', NULL);
+
+        printf_idx = 0U;
+        memset(printf_buffer, 0xCC, 100U);
+        fmt_ctxprintf(&a, _out_fct, NULL, "%d%Q", 1, "ab");
+        printf_buffer[printf_idx] = '\0';
+        REQUIRE_STREQ(printf_buffer, "1[ab4]");
+
+        printf_idx = 0U;
+        fmt_ctxprintf(&b, _out_fct, NULL, "%d%Q%s", "ab", "!");
+        printf_buffer[printf_idx] = '\0';
+        REQUIRE_STREQ(printf_buffer, "d<ab4>!");
+
+        // the default locale is unaffected
+        fmt_sprintf(buffer, "%d%Q", 1);
+        REQUIRE_STREQ(buffer, "1Q");
+
+        printf_idx = 0U;
+        fmt_ctxprintf(NULL, _out_fct, NULL, "%d%Q", 2);
+        printf_buffer[printf_idx] = '\0';
+        REQUIRE_STREQ(printf_buffer, "2Q");
+
+        // installs are limited, but re-installs don't use up more room
+        for (int i = 0; i < PICO_PRINTF_MAX_INSTALLED_SPECIFIERS-1; i++)
+            REQUIRE(fmt_locale_install_conv(&a, (char)('A'+i), _test_conv));
+        REQUIRE(!fmt_locale_install_conv(&a, 'z', _test_conv));
+        REQUIRE(fmt_locale_install_conv(&a, 'Q', NULL));
+        REQUIRE(fmt_locale_install_conv(&a, 'A', NULL));
+        REQUIRE(!fmt_locale_install(&a, 'A', _test_conv_legacy));
+        printf_idx = 0U;
+        fmt_ctxprintf(&a, _out_fct, NULL, "%Q%A%B", "xy");
+        printf_buffer[printf_idx] = '\0';
+        REQUIRE_STREQ(printf_buffer, "QA[xy5]");
+    }
+
+
+    TEST_CASE("sink", "[]" );
+    {
+        char buffer[100];
+        struct fmt_sink_buf buf;
+        struct fmt_sink *sink = fmt_sink_buf_init(&buf, buffer, sizeof(buffer));
+
+        // longer than PICO_PRINTF_SINK_BUFFER_SIZE, so it goes out in several chunks
+        REQUIRE(fmt_sinkprintf(sink, "%s %d %s", "The quick brown fox jumps over the lazy dog", 42, "and then the dog jumps over the fox") == 82);
+        buffer[buf.cur] = '\0';
+        REQUIRE_STREQ(buffer, "The quick brown fox jumps over the lazy dog 42 and then the dog jumps over the fox");
+
+        buf.cur = 0;
+        buf.maxlen = 3;
+        REQUIRE(fmt_sinkprintf(sink, "%d", 12345) == 5);
+        REQUIRE(buf.cur == 3);
+    }
+
+
+    TEST_CASE("sink locked", "[]" );
+    {
+        char buffer[100];
+        char stage[8];
+        struct fmt_sink_buf buf;
+        struct _test_locked_sink sink = {
+            .sink = { .write = _test_locked_write },
+            .next = fmt_sink_buf_init(&buf, buffer, sizeof(buffer)),
+        };
+        struct fmt_lock lock = {
+            .acquire = _test_lock_acquire,
+            .release = _test_lock_release,
+            .arg = &sink,
+        };
+
+        REQUIRE(fmt_sinkprintf_locked(&sink.sink, &lock, stage, sizeof(stage), "%d-%d", 12, 34) == 5);
+        REQUIRE(sink.acquires == 1);
+        REQUIRE(sink.writes == 1);
+        REQUIRE(!sink.locked);
+        REQUIRE(!sink.unlocked_writes);
+
+        // the fallback: hold the lock as soon as the stage fills
+        REQUIRE(fmt_sinkprintf_locked(&sink.sink, &lock, stage, sizeof(stage), "%s", "0123456789abcdefXYZ") == 19);
+        REQUIRE(sink.acquires == 2);
+        REQUIRE(sink.writes == 4);
+        REQUIRE(!sink.locked);
+        REQUIRE(!sink.unlocked_writes);
+
+        REQUIRE(buf.cur == 24);
+        REQUIRE(!memcmp(buffer, "12-340123456789abcdefXYZ", 24));
+
+        // no stage at all: the fallback from the start
+        REQUIRE(fmt_sinkprintf_locked(&sink.sink, &lock, NULL, 0, "%d", 42) == 2);
+        REQUIRE(sink.acquires == 3);
+        REQUIRE(sink.writes == 6);
+        REQUIRE(!sink.locked);
+        REQUIRE(!sink.unlocked_writes);
+        REQUIRE(buf.cur == 26);
+        REQUIRE(!memcmp(buffer + 24, "42", 2));
+    }
+
+
+    TEST_CASE("sink tee", "[]" );
+    {
+        char buffer[100];
+        struct fmt_sink_buf buf;
+        struct fmt_sink_fct fct;
+        struct fmt_sink *outs[] = {
+            fmt_sink_buf_init(&buf, buffer, sizeof(buffer)),
+            fmt_sink_fct_init(&fct, _out_fct, NULL),
+        };
+        struct fmt_sink_tee tee;
+        struct fmt_sink *sink = fmt_sink_tee_init(&tee, outs, 2);
+
+        printf_idx = 0U;
+        fmt_sinkprintf(sink, "x=%04x", 0xbeef);
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 6);
+        REQUIRE(printf_idx == 6);
+        REQUIRE(!memcmp(buffer, "x=beef", 6));
+        REQUIRE(!memcmp(printf_buffer, "x=beef", 6));
+    }
+
+
+    TEST_CASE("sink crc", "[]" );
+    {
+        char buffer[100];
+        struct fmt_sink_buf buf;
+        struct fmt_sink_crc32 crc32;
+        struct fmt_sink_crc16 crc16;
+        struct fmt_sink *sink;
+
+        sink = fmt_sink_crc32_init(&crc32, fmt_sink_buf_init(&buf, buffer, sizeof(buffer)), true);
+        fmt_sinkprintf(sink, "%d", 123456789);
+        REQUIRE(fmt_sink_crc32_value(&crc32) == 0xCBF43926);
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 13);
+        REQUIRE(!memcmp(buffer, "123456789\x26\x39\xF4\xCB", 13));
+        REQUIRE(fmt_sink_crc32_value(&crc32) == 0);
+
+        sink = fmt_sink_crc16_init(&crc16, fmt_sink_buf_init(&buf, buffer, sizeof(buffer)), true);
+        fmt_sinkprintf(sink, "%s%d", "1234", 56789);
+        REQUIRE(fmt_sink_crc16_value(&crc16) == 0x29B1);
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 11);
+        REQUIRE(!memcmp(buffer, "123456789\x29\xB1", 11));
+    }
+
+
+    TEST_CASE("sink cobs", "[]" );
+    {
+        char buffer[300];
+        char data[300];
+        struct fmt_sink_buf buf;
+        struct fmt_sink_cobs cobs;
+        struct fmt_sink *sink = fmt_sink_cobs_init(&cobs, fmt_sink_buf_init(&buf, buffer, sizeof(buffer)));
+
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 2);
+        REQUIRE(!memcmp(buffer, "\x01\x00", 2));
+
+        buf.cur = 0;
+        fmt_sinkprintf(sink, "%c%c%c%c", 0x11, 0x22, 0x00, 0x33);
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 6);
+        REQUIRE(!memcmp(buffer, "\x03\x11\x22\x02\x33\x00", 6));
+
+        buf.cur = 0;
+        fmt_sinkprintf(sink, "%c%c", 0x00, 0x00);
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 4);
+        REQUIRE(!memcmp(buffer, "\x01\x01\x01\x00", 4));
+
+        // a full 254-byte block has no implied zero after it
+        for (int i = 0; i < 254; i++)
+            data[i] = (char)(i+1);
+        data[254] = '\0';
+        buf.cur = 0;
+        fmt_sinkprintf(sink, "%s", data);
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 256);
+        REQUIRE(buffer[0] == (char)0xFF);
+        REQUIRE(!memcmp(&buffer[1], data, 254));
+        REQUIRE(buffer[255] == 0x00);
+
+        data[254] = (char)0xFF;
+        data[255] = '\0';
+        buf.cur = 0;
+        fmt_sinkprintf(sink, "%s", data);
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 258);
+        REQUIRE(buffer[0] == (char)0xFF);
+        REQUIRE(!memcmp(&buffer[255], "\x02\xFF\x00", 3));
+    }
+
+
+    TEST_CASE("sink slip", "[]" );
+    {
+        char buffer[100];
+        struct fmt_sink_buf buf;
+        struct fmt_sink_slip slip;
+        struct fmt_sink *sink = fmt_sink_slip_init(&slip, fmt_sink_buf_init(&buf, buffer, sizeof(buffer)));
+
+        fmt_sinkprintf(sink, "a%cb%cc", 0xC0, 0xDB);
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 8);
+        REQUIRE(!memcmp(buffer, "a\xDB\xDC" "b\xDB\xDD" "c\xC0", 8));
+    }
+
+
+    TEST_CASE("sink lines", "[]" );
+    {
+        char buffer[100];
+        char linebuf[8];
+        struct fmt_sink_buf buf;
+        struct fmt_sink_slip slip;
+        struct fmt_sink_lines lines;
+        struct fmt_sink *sink = fmt_sink_lines_init(&lines,
+            fmt_sink_slip_init(&slip, fmt_sink_buf_init(&buf, buffer, sizeof(buffer))),
+            linebuf, sizeof(linebuf));
+
+        fmt_sinkprintf(sink, "%d\n%s\n%s", 1, "two", "thr");
+        fmt_sinkprintf(sink, "ee\nlonger than cap\n");
+        REQUIRE(buf.cur == 32);
+        buffer[buf.cur] = '\0';
+        REQUIRE_STREQ(buffer, "1\n\xC0" "two\n\xC0" "three\n\xC0" "longer than cap\n\xC0");
+
+        fmt_sinkprintf(sink, "tail");
+        REQUIRE(buf.cur == 32);
+        fmt_sink_flush(sink);
+        REQUIRE(buf.cur == 37);
+
+        // a long line with nothing pending still goes in cap-sized
+        // writes
+        struct _test_locked_sink count = {
+            .sink = { .write = _test_locked_write },
+            .next = fmt_sink_buf_init(&buf, buffer, sizeof(buffer)),
+        };
+        sink = fmt_sink_lines_init(&lines, &count.sink, linebuf, sizeof(linebuf));
+        fmt_sink_write(sink, "0123456789abcdefXYZ\n", 20);
+        REQUIRE(count.writes == 3);
+        REQUIRE(buf.cur == 20);
+
+        // with no buffer, writes pass straight through
+        sink = fmt_sink_lines_init(&lines, &count.sink, NULL, 0);
+        fmt_sinkprintf(sink, "%s\n%s", "ab", "cd");
+        REQUIRE(buf.cur == 25);
+        REQUIRE(!memcmp(buffer + 20, "ab\ncd", 5));
+    }
+
+
+    TEST_CASE("sink limit", "[]" );
+    {
+        char buffer[100];
+        struct fmt_sink_buf buf;
+        struct fmt_sink_limit limit;
+        struct fmt_sink *sink = fmt_sink_limit_init(&limit, fmt_sink_buf_init(&buf, buffer, sizeof(buffer)), 5);
+
+        REQUIRE(fmt_sinkprintf(sink, "%s", "abc") == 3);
+        REQUIRE(fmt_sinkprintf(sink, "%s", "defg") == 4);
+        REQUIRE(buf.cur == 5);
+        REQUIRE(limit.dropped == 2);
+        fmt_sink_limit_refill(&limit, 2);
+        fmt_sinkprintf(sink, "%s", "hij");
+        REQUIRE(buf.cur == 7);
+        REQUIRE(limit.dropped == 3);
+        REQUIRE(!memcmp(buffer, "abcdehi", 7));
+    }
+
+
+    TEST_CASE("batch", "[]" );
+    {
+        char buffer[100];
+        struct { uint32_t ts; int8_t temp; const char *name; } rows[] = {
+            { 1, -5, "a" },
+            { 22, 7, "bb" },
+            { 333, -128, "ccc" },
+        };
+        const struct fmt_column cols[] = {
+            FMT_FIELD(FMT_TYPE_UINT32, rows, ts),
+            FMT_FIELD(FMT_TYPE_INT8, rows, temp),
+            FMT_FIELD(FMT_TYPE_INT8, rows, temp),
+            FMT_FIELD(FMT_TYPE_STR, rows, name),
+        };
+
+        REQUIRE(fmt_batch_snprintf(buffer, sizeof(buffer), "%u,%d,%02hhx,%-4s|\n", cols, 4, 3) == 46);
+        REQUIRE_STREQ(buffer, "1,-5,fb,a   |\n22,7,07,bb  |\n333,-128,80,ccc |\n");
+
+        // columnar, with "*"
+        const int widths[] = { 3, -3 };
+        const char *strs[] = { "x", "y" };
+        const struct fmt_column cols2[] = {
+            FMT_COLUMN(FMT_TYPE_INT, widths),
+            FMT_COLUMN(FMT_TYPE_STR, strs),
+        };
+        REQUIRE(fmt_batch_snprintf(buffer, sizeof(buffer), "[%*s]%%", cols2, 2, 2) == 12);
+        REQUIRE_STREQ(buffer, "[  x]%[y  ]%");
+
+        const char chs[] = { 'p', 'q' };
+        const uint16_t u16s[] = { 0xbeef, 0xf00d };
+        const int64_t i64s[] = { -1, 1234567890123 };
+        const struct fmt_column cols4[] = {
+            FMT_COLUMN(FMT_TYPE_STR, strs),
+            FMT_COLUMN(FMT_TYPE_CHAR, chs),
+            FMT_COLUMN(FMT_TYPE_UINT16, u16s),
+            FMT_COLUMN(FMT_TYPE_INT64, i64s),
+            FMT_COLUMN(FMT_TYPE_INT64, i64s),
+        };
+        fmt_batch_snprintf(buffer, sizeof(buffer), "%s%c%X %d %x;", cols4, 5, 2);
+#if PICO_PRINTF_SUPPORT_LONG_LONG
+        REQUIRE_STREQ(buffer, "xpBEEF -1 ffffffffffffffff;yqF00D 1234567890123 11f71fb04cb;");
+#endif
+
+#if PICO_PRINTF_SUPPORT_FLOAT
+        const float volts[] = { 1.5f, 3.25f };
+        const struct fmt_column cols3[] = { FMT_COLUMN(FMT_TYPE_FLOAT, volts) };
+        REQUIRE(fmt_batch_snprintf(buffer, sizeof(buffer), "%.2f ", cols3, 1, 2) == 10);
+        REQUIRE_STREQ(buffer, "1.50 3.25 ");
+#endif
+
+        // the same through a sink
+        struct fmt_sink_buf buf;
+        struct fmt_sink *sink = fmt_sink_buf_init(&buf, buffer, sizeof(buffer));
+        REQUIRE(fmt_batch_sink(sink, "[%*s]%%", cols2, 2, 2) == 12);
+        REQUIRE(buf.cur == 12);
+        REQUIRE(!memcmp(buffer, "[  x]%[y  ]%", 12));
+
+        // the format and the columns must agree
+        REQUIRE(fmt_batch_snprintf(buffer, sizeof(buffer), "%u,%d,%x", cols, 4, 3) == -1);
+        REQUIRE(fmt_batch_snprintf(buffer, sizeof(buffer), "%u,%d,%x,%s,%d", cols, 4, 3) == -1);
+        REQUIRE(fmt_batch_snprintf(buffer, sizeof(buffer), "%u,%s,%x,%s", cols, 4, 3) == -1);
+        REQUIRE_STREQ(buffer, "");
+    }
+
+
+    TEST_CASE("batch unsigned", "[]" );
+    {
+        // "%d" of an unsigned column prints its own value, as printf
+        // would given the column's type (bare, and with a width)
+        char buffer[100];
+        const uint8_t u8s[] = { 200, 255 };
+        const uint32_t u32s[] = { 0x80000000U, 0xFFFFFFFFU };
+        const unsigned char ucs[] = { 200, 7 };
+        const struct fmt_column cols[] = {
+            FMT_COLUMN(FMT_TYPE_UINT8, u8s),
+            FMT_COLUMN(FMT_TYPE_UINT8, u8s),
+            FMT_COLUMN(FMT_TYPE_UINT32, u32s),
+            FMT_COLUMN(FMT_TYPE_UINT32, u32s),
+        };
+        REQUIRE(fmt_batch_snprintf(buffer, sizeof(buffer), "%d|%5d|%d|%12d;", cols, 4, 2) == 68);
+        REQUIRE_STREQ(buffer, "200|  200|2147483648|  2147483648;255|  255|4294967295|  4294967295;");
+        REQUIRE(fmt_batch_snprintf(buffer, sizeof(buffer), "%i %u %x;", cols, 3, 1) == 17);
+        REQUIRE_STREQ(buffer, "200 200 80000000;");
+
+        const struct fmt_column chars[] = { FMT_COLUMN(FMT_TYPE_CHAR, ucs) };
+        fmt_batch_snprintf(buffer, sizeof(buffer), "%d,", chars, 1, 2);
+        REQUIRE_STREQ(buffer, (char) -1 < 0 ? "-56,7," : "200,7,");
+    }
+
+
+    TEST_CASE("args", "[]" );
+    {
+        char buffer[100];
+        const struct fmt_arg args[] = {
+            FMT_ARG_INT(-42),
+            FMT_ARG_STR("str"),
+            FMT_ARG_UINT(0xbeef),
+            { .type = FMT_TYPE_INT8, .i = -1 },
+            FMT_ARG_CHAR('c'),
+            FMT_ARG_INT(6),
+            FMT_ARG_LLONG(-1234567890123LL),
+        };
+
+        // the same array may be used more than once
+        for (int i = 0; i < 2; i++) {
+            REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%d %-4s|%#X %x %c %*d", args, 7) == 35);
+            REQUIRE_STREQ(buffer, "-42 str |0XBEEF ff c -1234567890123");
+        }
+
+        // the argument's type is what matters, not the length modifier
+        REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%hhu %lld", &args[2], 2) == 8);
+        REQUIRE_STREQ(buffer, "48879 -1");
+
+        // an argument keeps its own value, as it would through "..."; a
+        // negative one wraps around at its own width for "%u" and "%x"
+        const struct fmt_arg widths[] = {
+            { .type = FMT_TYPE_UINT8, .u = 255 },
+            { .type = FMT_TYPE_UINT16, .u = 60000 },
+            FMT_ARG_UINT(0x80000000U),
+            { .type = FMT_TYPE_INT8, .i = -1 },
+            { .type = FMT_TYPE_INT16, .i = -2 },
+        };
+        REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%d %i %ld", widths, 3) == 20);
+        REQUIRE_STREQ(buffer, "255 60000 2147483648");
+        fmt_snprintf_args(buffer, sizeof(buffer), "%5d|%+d|%-11ld|", widths, 3);
+        REQUIRE_STREQ(buffer, "  255|+60000|2147483648 |");
+        fmt_snprintf_args(buffer, sizeof(buffer), "%u %x", &widths[3], 2);
+        REQUIRE_STREQ(buffer, "255 fffe");
+        fmt_snprintf_args(buffer, sizeof(buffer), "%5u|%#x", &widths[3], 2);
+        REQUIRE_STREQ(buffer, "  255|0xfffe");
+
+        // not enough arguments, or the wrong kind
+        REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%d %d", args, 1) == -1);
+        REQUIRE_STREQ(buffer, "-42 ");
+        REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%d %d", args, 2) == -1);
+        REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%s", args, 1) == -1);
+
+#if PICO_PRINTF_SUPPORT_FLOAT
+        const struct fmt_arg d = FMT_ARG_DOUBLE(2.5);
+        REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%.2f", &d, 1) == 4);
+        REQUIRE_STREQ(buffer, "2.50");
+#endif
+
+        // installed specifiers read theirs with fmt_conv_arg()
+        fmt_install_conv('Y', _test_conv_arg);
+        const struct fmt_arg y[] = { FMT_ARG_INT(-3), FMT_ARG_INT(0x18000) };
+        REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%Y%Y", y, 2) == 6);
+        REQUIRE_STREQ(buffer, "{-}{-}");
+        fmt_snprintf(buffer, sizeof(buffer), "%Y%Y", -3, 0x8000);
+        REQUIRE_STREQ(buffer, "{-}{-}");
+        REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%Y%Y", y, 1) == -1);
+        fmt_install_conv('Y', NULL);
+
+        struct fmt_sink_buf buf;
+        struct fmt_sink *sink = fmt_sink_buf_init(&buf, buffer, sizeof(buffer));
+        REQUIRE(fmt_sinkprintf_args(sink, "%s!", &args[1], 1) == 4);
+        REQUIRE(buf.cur == 4);
+        REQUIRE(!memcmp(buffer, "str!", 4));
+    }
+
+
+    TEST_CASE("generic", "[]" );
+    {
+        char buffer[100];
+        const short s = -5;
+        const unsigned char uc = 200;
+        const long l = -1234567890L;
+        char name[] = "pump";
+
+        REQUIRE(FMT_SNPRINTF(buffer, sizeof(buffer), "%d %u %ld %s|%c|%5s", s, uc, l, name, 'q', "ab") == 31);
+        REQUIRE_STREQ(buffer, "-5 200 -1234567890 pump|q|   ab");
+        REQUIRE(FMT_SNPRINTF(buffer, sizeof(buffer), "%d %d|%5d", (uint8_t) 200, (uint16_t) 60000, uc) == 15);
+        REQUIRE_STREQ(buffer, "200 60000|  200");
+        REQUIRE(FMT_SNPRINTF(buffer, sizeof(buffer), "none") == 4);
+        REQUIRE_STREQ(buffer, "none");
+#if PICO_PRINTF_SUPPORT_FLOAT
+        REQUIRE(FMT_SNPRINTF(buffer, sizeof(buffer), "%.2f %.1f", 2.5f, 0.25) == 8);
+        REQUIRE_STREQ(buffer, "2.50 0.2");
+#endif
+
+        // each argument is tagged with its own type
+        REQUIRE(FMT_ARG(s).type == FMT_TYPE_INT16);
+        REQUIRE(FMT_ARG(uc).type == FMT_TYPE_UINT8);
+        REQUIRE(FMT_ARG(name).type == FMT_TYPE_STR);
+        REQUIRE(FMT_ARG((void *) name).type == FMT_TYPE_PTR);
+        REQUIRE(FMT_ARG(1.0f).type == FMT_TYPE_FLOAT);
+
+        // so a mismatch is caught rather than misread
+        const struct fmt_arg str = FMT_ARG(name);
+        REQUIRE(fmt_snprintf_args(buffer, sizeof(buffer), "%d", &str, 1) == -1);
+
+        struct fmt_sink_buf buf;
+        struct fmt_sink *sink = fmt_sink_buf_init(&buf, buffer, sizeof(buffer));
+        REQUIRE(FMT(sink, "%s=%x", name, 255U) == 7);
+        REQUIRE(!memcmp(buffer, "pump=ff", 7));
+    }
+
+    TEST_CASE("positional", "[]" );
+    {
+        char buffer[100];
+
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%2$s: %1$d", -7, "pump") == 8);
+        REQUIRE_STREQ(buffer, "pump: -7");
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "[%1$s|%1$-5s|%2$c]", "ab", 'z') == 12);
+        REQUIRE_STREQ(buffer, "[ab|ab   |z]");
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%3$*1$.*2$d|%4$lx|%5$hhd%%", 6, 3, 42, 0xdeadbeefUL, 0x1ff) == 19);
+        REQUIRE_STREQ(buffer, "   042|deadbeef|-1%");
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%2$llu %1$c", 'x', 1234567890123ULL) == 15);
+        REQUIRE_STREQ(buffer, "1234567890123 x");
+#if PICO_PRINTF_SUPPORT_FLOAT
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%2$s=%1$.2f", 2.5, "v") == 6);
+        REQUIRE_STREQ(buffer, "v=2.50");
+#endif
+
+        // "%$" and "%-1$" aren't positional
+        fmt_snprintf(buffer, sizeof(buffer), "%$%-1$");
+        REQUIRE_STREQ(buffer, "$$");
+
+        // no gaps, no mixing, no conflicting types, and at most
+        // PICO_PRINTF_MAX_POSITIONAL_ARGS
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%2$d", 1, 2) == -1);
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%1$d %d", 1, 2) == -1);
+        // (sequential first is caught at the first positional
+        // directive, after what comes before it is output)
+        memset(buffer, 'x', sizeof(buffer));
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%d %1$d", 1, 2) == -1);
+        REQUIRE_STREQ(buffer, "1 ");
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%d %2$d %1$d", 1, 2, 3) == -1);
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%*d %1$d", 1, 2) == -1);
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%% %1$d", 1) == 3);
+        REQUIRE_STREQ(buffer, "% 1");
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%1$d %1$s", 1) == -1);
+        REQUIRE(fmt_snprintf(buffer, sizeof(buffer), "%99$d", 1) == -1);
+    }
+
+    TEST_CASE("format", "[]" );
+    {
+        char buffer[100];
+        const struct fmt_arg args[] = {
+            FMT_ARG_INT(-42), FMT_ARG_STR("ab"), FMT_ARG_UINT(255U), FMT_ARG_CHAR('z'),
+        };
+
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{} {} {} {}", args, 4) == 12);
+        REQUIRE_STREQ(buffer, "-42 ab 255 z");
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "[{:5}|{:5}|{:>5}|{:<5}]", args, 4) == 25);
+        REQUIRE_STREQ(buffer, "[  -42|ab   |  255|z    ]");
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{:+06}|{:^6}|{:#x}|{:d}", args, 4) == 22);
+        REQUIRE_STREQ(buffer, "-00042|  ab  |0xff|122");
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{0:*^7}{2:X}{1:.1}{0:x}", args, 4) == 13);
+        REQUIRE_STREQ(buffer, "**-42**FFa-2a");
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{{{}}}", args, 1) == 5);
+        REQUIRE_STREQ(buffer, "{-42}");
+
+        // nested widths and precisions
+        const struct fmt_arg nested[] = { FMT_ARG_STR("abcdef"), FMT_ARG_INT(6), FMT_ARG_SIZE(3) };
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "[{:>{}.{}}]", nested, 3) == 8);
+        REQUIRE_STREQ(buffer, "[   abc]");
+#if PICO_PRINTF_SUPPORT_FLOAT && PICO_PRINTF_SUPPORT_EXPONENTIAL
+        const struct fmt_arg f[] = { FMT_ARG_DOUBLE(3.14159) };
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{}|{:>8.3f}|{:.2e}", f, 1) == -1);
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{0}|{0:>8.3f}|{0:.2e}", f, 1) == 25);
+        REQUIRE_STREQ(buffer, "3.14159|   3.142|3.14e+00");
+#endif
+
+        // malformed formats, and arguments that are missing or of the
+        // wrong kind
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{", args, 4) == -1);
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "}", args, 4) == -1);
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{:5", args, 4) == -1);
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{0}{}", args, 4) == -1);
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{4}", args, 4) == -1);
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{:s}", args, 4) == -1);
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{:.2}", args, 4) == -1);
+        REQUIRE(fmt_snformat_args(buffer, sizeof(buffer), "{:{}}", args, 4) == -1);
+
+        struct fmt_sink_buf buf;
+        struct fmt_sink *sink = fmt_sink_buf_init(&buf, buffer, sizeof(buffer));
+        const char name[] = "pump";
+        REQUIRE(FMT_FORMAT(sink, "{}={:02x}", name, 10U) == 7);
+        REQUIRE(!memcmp(buffer, "pump=0a", 7));
+        REQUIRE(FMT_SNFORMAT(buffer, sizeof(buffer), "{1}{0}", (char) 'a', (short) -1) == 3);
+        REQUIRE_STREQ(buffer, "-1a");
+    }
+
+    TEST_CASE("maxlen", "[]" );
+    {
+        char buffer[100];
+
+        REQUIRE(fmt_maxlen("Hello testing") == 13);
+        REQUIRE(fmt_maxlen("%d") == 11);
+        REQUIRE(fmt_maxlen("%d") == (size_t) fmt_snprintf(buffer, sizeof(buffer), "%d", INT_MIN));
+        REQUIRE(fmt_maxlen("%lld") == (size_t) fmt_snprintf(buffer, sizeof(buffer), "%lld", LLONG_MIN));
+        REQUIRE(fmt_maxlen("%llu") == (size_t) fmt_snprintf(buffer, sizeof(buffer), "%llu", ULLONG_MAX));
+        REQUIRE(fmt_maxlen("%#llo") == (size_t) fmt_snprintf(buffer, sizeof(buffer), "%#llo", ULLONG_MAX));
+        REQUIRE(fmt_maxlen("%hhu|%hd|%x|%#b") == 3 + 1 + 6 + 1 + 8 + 1 + 34);
+        REQUIRE(fmt_maxlen("[%5d|%20d|%.15d|%-+.15d]") == 2 + 11 + 1 + 20 + 1 + 16 + 1 + 16);
+        REQUIRE(fmt_maxlen("%c%5c%%%.3s%8.3s") == 1 + 5 + 1 + 3 + 8);
+        REQUIRE(fmt_maxlen("%p") == 2 * sizeof(void *));
+        REQUIRE(fmt_maxlen("%.3e|%f|%.3f|%08.2f|%g|%.10g") == 12 + 1 + 18 + 1 + 15 + 1 + 14 + 1 + 15 + 1 + 18);
+        REQUIRE(fmt_maxlen("%2$.4s=%1$.2f") == 4 + 1 + 14);
+        REQUIRE(fmt_maxlen("ab%") == 2);
+
+        // unbounded
+        REQUIRE(fmt_maxlen("%s") == FMT_MAXLEN_UNBOUNDED);
+        REQUIRE(fmt_maxlen("%*d") == FMT_MAXLEN_UNBOUNDED);
+        REQUIRE(fmt_maxlen("%.*d!") == FMT_MAXLEN_UNBOUNDED);
+        fmt_install_conv('Q', _test_conv);
+        REQUIRE(fmt_maxlen("%Q") == FMT_MAXLEN_UNBOUNDED);
+        fmt_install_conv('Q', NULL);
+
+        // and as a constant expression
+        static char temp[sizeof("temp=") - 1 + FMT_MAXLEN_DIRECTIVE('d', 0, 0, 0, sizeof(short) * CHAR_BIT) + 1];
+        REQUIRE(sizeof(temp) == 12);
+        REQUIRE(fmt_snprintf(temp, sizeof(temp), "temp=%hd", SHRT_MIN) == 11);
+        REQUIRE_STREQ(temp, "temp=-32768");
+        REQUIRE(FMT_MAXLEN_DIRECTIVE('s', FMT_FLAG_PRECISION, 0, 4, 0) == 4);
+        REQUIRE(FMT_MAXLEN_DIRECTIVE('s', 0, 10, 0, 0) == FMT_MAXLEN_UNBOUNDED);
+    }
+    TEST_CASE("limited", "[]" );
+    {
+        char buffer[100];
+        const struct fmt_limits limits = {
+            .max_output     = 20,
+            .max_width      = 8,
+            .max_precision  = 4,
+            .max_directives = 3,
+        };
+
+        // within the limits, the same as fmt_snprintf()
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "%d %.3s %8x", -5, "abcdef", 0xbeefU) == 15);
+        REQUIRE_STREQ(buffer, "-5 abc     beef");
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "[%-*d|%.*d]", -6, 1, 4, 2) == 13);
+        REQUIRE_STREQ(buffer, "[1     |0002]");
+
+        // cut down, but carried on with
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "[%*d]", INT_MAX, 1) == FMT_LIMITED);
+        REQUIRE_STREQ(buffer, "[       1]");
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "%.50d|%.*s", 7, 1000, "abcdef") == FMT_LIMITED);
+        REQUIRE_STREQ(buffer, "0007|abcd");
+        // (not even read past max_precision, so it needn't be terminated;
+        // and so a string that fills it counts as cut off)
+        const char unterminated[4] = {'v', 'w', 'x', 'y'};
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "%s!", unterminated) == FMT_LIMITED);
+        REQUIRE_STREQ(buffer, "vwxy!");
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "%s!", "vwxy") == FMT_LIMITED);
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "%s!", "vwx") == 4);
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "%.0s|%.2s|%3.1s", unterminated, unterminated,
+                                     unterminated) == 7);
+        REQUIRE_STREQ(buffer, "|vw|  v");
+        const struct fmt_limits none = {
+            .max_output     = 20,
+            .max_width      = 8,
+            .max_precision  = 0,
+            .max_directives = 3,
+        };
+        REQUIRE(fmt_snprintf_limited(&none, buffer, sizeof(buffer), "[%s]", unterminated) == FMT_LIMITED);
+        REQUIRE_STREQ(buffer, "[]");
+
+        // stopped
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "%d%d%d%d", 1, 2, 3, 4) == FMT_LIMITED);
+        REQUIRE_STREQ(buffer, "123");
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "%8d|%8d|%8d", 1, 2, 3) == FMT_LIMITED);
+        REQUIRE_STREQ(buffer, "       1|       2|  ");
+        size_t n = 0;
+        REQUIRE(fmt_fctprintf_limited(&limits, _count_fct, &n, "%8d|%8d|%8d", 1, 2, 3) == FMT_LIMITED);
+        REQUIRE(n == limits.max_output);
+        REQUIRE(fmt_snprintf_limited(&limits, buffer, sizeof(buffer), "%1$d", 1) == -1);
+
+        // the documented bound on how many characters are generated,
+        // whatever the arguments
+        const struct fmt_limits wide = {
+            .max_output     = (size_t) -1,
+            .max_width      = 30,
+            .max_precision  = 25,
+            .max_directives = 1,
+        };
+        const size_t bound = wide.max_width + wide.max_precision + 67;
+        n = 0;
+        fmt_fctprintf_limited(&wide, _count_fct, &n, "%#*llb", INT_MIN + 1, ULLONG_MAX);
+        REQUIRE(n <= bound);
+        n = 0;
+        fmt_fctprintf_limited(&wide, _count_fct, &n, "%+0*.*lld", INT_MAX, INT_MAX, LLONG_MIN);
+        REQUIRE(n <= bound);
+        n = 0;
+        fmt_fctprintf_limited(&wide, _count_fct, &n, "% #*.*p", INT_MAX, INT_MAX, (void *) &n);
+        REQUIRE(n <= bound);
+#if PICO_PRINTF_SUPPORT_FLOAT
+        n = 0;
+        fmt_fctprintf_limited(&wide, _count_fct, &n, "%+*.*f", INT_MAX, INT_MAX, -1e9);
+        REQUIRE(n <= bound);
+        n = 0;
+        fmt_fctprintf_limited(&wide, _count_fct, &n, "%-*.*e", INT_MAX, INT_MAX, -1e-300);
+        REQUIRE(n <= bound);
+        n = 0;
+        fmt_fctprintf_limited(&wide, _count_fct, &n, "% *.*g", INT_MAX, INT_MAX, -0.00012345);
+        REQUIRE(n <= bound);
+#endif
+    }
+
+#if PICO_FMT_TEST_CODEGEN
+    // the same expectations as for fmt_sprintf() above
+    TEST_CASE("codegen", "[]" );
+    {
+        char buffer[200];
+        char expect[200];
+
+        REQUIRE(gen_hello_snprintf(buffer, sizeof(buffer)) == 13);
+        REQUIRE_STREQ(buffer, "Hello testing");
+        gen_space_d_snprintf(buffer, sizeof(buffer), 42);
+        REQUIRE_STREQ(buffer, "   42");
+        gen_space_d_snprintf(buffer, sizeof(buffer), -42);
+        REQUIRE_STREQ(buffer, "  -42");
+        gen_plus_d_snprintf(buffer, sizeof(buffer), 42);
+        REQUIRE_STREQ(buffer, "+42");
+        gen_zero_d_snprintf(buffer, sizeof(buffer), -5);
+        REQUIRE_STREQ(buffer, "-005");
+        gen_left_snprintf(buffer, sizeof(buffer), 42, "ab");
+        REQUIRE_STREQ(buffer, "[42    |ab  ]");
+        gen_hash_snprintf(buffer, sizeof(buffer), 0x614e, 6);
+        REQUIRE_STREQ(buffer, "0x0000614e 0b110");
+        gen_bare_snprintf(buffer, sizeof(buffer), -2147483647 - 1, 0, 4294967295U, 0xbeefU, 0xbeefU, 'z', "ok");
+        REQUIRE_STREQ(buffer, "-2147483648 0 4294967295 beef BEEF z ok");
+        REQUIRE(gen_bare_snprintf(buffer, 4, -12, 0, 0, 0, 0, 'z', "ok") == 16);
+        REQUIRE_STREQ(buffer, "-12");
+        gen_octal_snprintf(buffer, sizeof(buffer), 4294966785U);
+        REQUIRE_STREQ(buffer, "37777777001");
+        gen_misc_snprintf(buffer, sizeof(buffer), 5, 3000, 'a', -20, "bit");
+        REQUIRE_STREQ(buffer, "53000atest-20 bit");
+        gen_star_snprintf(buffer, sizeof(buffer), -1, 1, -3, "hi");
+        REQUIRE_STREQ(buffer, "1|hi x");
+        gen_prec_snprintf(buffer, sizeof(buffer), "foobar", 0, 4);
+        REQUIRE_STREQ(buffer, "foo| |     00004");
+        gen_length_snprintf(buffer, sizeof(buffer), -1234567890L, 1234567890123ULL, -1, 0xffff);
+        REQUIRE_STREQ(buffer, "-1234567890 1234567890123 -1 ffff");
+        gen_unsigned_d_snprintf(buffer, sizeof(buffer), 200, 200, 4294967295U, 60000);
+        REQUIRE_STREQ(buffer, "200|  200|4294967295|60000 ");
+        gen_char_d_snprintf(buffer, sizeof(buffer), (char) 200);
+        REQUIRE_STREQ(buffer, (char) -1 < 0 ? "-56" : "200");
+        REQUIRE(gen_pct_snprintf(buffer, sizeof(buffer), 50) == 8);
+        REQUIRE_STREQ(buffer, "100% 50%");
+#if PICO_PRINTF_SUPPORT_FLOAT
+        gen_float_snprintf(buffer, sizeof(buffer), -42.987, 2, 0.33333333);
+        REQUIRE_STREQ(buffer, "        -42.987|0.33");
+#endif
+#if PICO_PRINTF_SUPPORT_FLOAT && PICO_PRINTF_SUPPORT_EXPONENTIAL
+        gen_exp_snprintf(buffer, sizeof(buffer), 0.33333333, 3.14159);
+        REQUIRE_STREQ(buffer, "3.33e-01|3.14159");
+#endif
+
+        // literals longer than the sink's staging buffer go straight through
+        struct fmt_sink_buf buf;
+        const int len = fmt_snprintf(expect, sizeof(expect), "The quick brown fox jumps over the lazy dog, %d times, "
+                                     "and then the lazy dog jumps back over the quick brown fox\n", 3);
+        REQUIRE(gen_long_literal(fmt_sink_buf_init(&buf, buffer, sizeof(buffer)), 3) == len);
+        REQUIRE(buf.cur == (size_t) len && !memcmp(buffer, expect, (size_t) len));
+
+        // NAME_MAXLEN, where it's bounded
+        REQUIRE(gen_hello_MAXLEN == 13);
+        REQUIRE(gen_hash_MAXLEN == fmt_maxlen("%#.8x %#b"));
+        REQUIRE(gen_length_MAXLEN == fmt_maxlen("%ld %llu %hhd %hx"));
+        REQUIRE(gen_pct_MAXLEN == fmt_maxlen("100%% %d%%"));
+        REQUIRE(gen_exp_MAXLEN == fmt_maxlen("%.2e|%g"));
+#if defined(gen_left_MAXLEN) || defined(gen_star_MAXLEN) || defined(gen_float_MAXLEN)
+        REQUIRE(!"an unbounded NAME_MAXLEN is defined");
+#endif
+    }
+#endif
+
+#if LIB_PICO_FMT_PARALLEL
+    TEST_CASE("batch parallel", "[]" );
+    {
+        static char buffer[16000];
+        static char expect[16000];
+        static unsigned int vals[1000];
+        size_t len = 0;
+        for (unsigned int i = 0; i < 1000; i++) {
+            vals[i] = i * 7U;
+            len += (size_t) fmt_snprintf(&expect[len], sizeof(expect) - len, "%u:%x\n", vals[i], vals[i]);
+        }
+        const struct fmt_column cols[] = {
+            FMT_COLUMN(FMT_TYPE_UINT, vals),
+            FMT_COLUMN(FMT_TYPE_UINT, vals),
+        };
+
+        for (unsigned int nthreads = 0; nthreads <= 5; nthreads++) {
+            FILE *f = tmpfile();
+            REQUIRE(fmt_batch_writev(fileno(f), nthreads, "%u:%x\n", cols, 2, 1000) == (ssize_t) len);
+            rewind(f);
+            REQUIRE(fread(buffer, 1, sizeof(buffer), f) == len);
+            REQUIRE(!memcmp(buffer, expect, len));
+            fclose(f);
+        }
+
+        REQUIRE(fmt_batch_writev(1, 2, "%u:%s\n", cols, 2, 1000) == -1);
+    }
+#endif
+
+
     if (failures) {
         printf("%u failures\n", failures);
         return 1;
@@ -53,6 +53,98 @@ extern "C" {
      * \return The number of characters that are sent to the output function, not counting the terminating null character
      */
     int vfctprintf(void (*out)(char character, void *arg), void *arg, const char *format, va_list va);
+
+    /**
+     * \brief printf to stdout, formatting before taking the stdout lock
+     *
+     * pico_stdio's printf() holds the stdout lock for the entire call,
+     * including all of the number conversion.  This instead formats in
+     * to a PICO_PRINTF_STDOUT_BUFFER_SIZE-byte buffer on the caller's
+     * stack, and only takes the lock to hand the finished output to
+     * pico_stdio in a single stdio_put_string() call.
+     *
+     * Output longer than the buffer is handed over in buffer-sized
+     * chunks as the buffer fills, each taking the lock separately; so
+     * other output may be interleaved between the chunks of a long
+     * message.  Raise PICO_PRINTF_STDOUT_BUFFER_SIZE to cover your
+     * longest lines if that matters.
+     */
+    int fmt_stdio_vprintf(const char *format, va_list va);
+    int __printflike(1, 2) fmt_stdio_printf(const char *format, ...);
+
+    // PICO_CONFIG: PICO_PRINTF_INLINE_CONST_FORMATS, Have sprintf/snprintf calls with a constant format that is only literal text or is exactly "%s" or "%d" skip the printf engine (C with GCC only), type=bool, default=0, group=pico_printf
+    #ifndef PICO_PRINTF_INLINE_CONST_FORMATS
+        #define PICO_PRINTF_INLINE_CONST_FORMATS 0
+    #endif
+
+    #if PICO_PRINTF_INLINE_CONST_FORMATS && defined(__GNUC__) && !defined(__clang__) && !defined(__cplusplus)
+        // sprintf() and snprintf() become these always-inline
+        // functions, which the compiler resolves once it has inlined
+        // them and can see the format:
+        //
+        //  - literal text only: copied in place
+        //  - "%s" or "%d": _pico_printf_snprintf_s/_d()
+        //  - anything else (or a format that isn't constant, or no
+        //    optimization): the (wrapped) sprintf()/snprintf() as before
+        //
+        // For the first two, sprintf() in to a buffer whose size the
+        // compiler knows is truncated to fit it rather than
+        // overflowing it; the wrapped sprintf() that anything else
+        // falls through to is not.
+        //
+        // __builtin_va_arg_pack() may only be passed on to a variadic
+        // function, hence the `...` on _pico_printf_snprintf_s/_d().
+        int _pico_printf_snprintf_s(char *buffer, size_t count, ...);
+        int _pico_printf_snprintf_d(char *buffer, size_t count, ...);
+
+        #define _PICO_PRINTF_IS_LITERAL(format) \
+            (__builtin_constant_p(!__builtin_strchr(format, '%')) && !__builtin_strchr(format, '%'))
+        #define _PICO_PRINTF_IS(format, str) \
+            (__builtin_va_arg_pack_len() == 1 && __builtin_constant_p(__builtin_strcmp(format, str)) && !__builtin_strcmp(format, str))
+
+        static inline __attribute__((always_inline, artificial))
+        int _pico_printf_copy_literal(char *buffer, size_t count, const char *format) {
+            const size_t len = __builtin_strlen(format);
+            if (count) {
+                const size_t n = len < count ? len : count - 1;
+                __builtin_memcpy(buffer, format, n);
+                buffer[n] = '\0';
+            }
+            return (int) len;
+        }
+
+        static inline __attribute__((always_inline, artificial)) __printflike(3, 4)
+        int _pico_printf_snprintf(char *buffer, size_t count, const char *format, ...) {
+            if (_PICO_PRINTF_IS_LITERAL(format)) {
+                return _pico_printf_copy_literal(buffer, count, format);
+            }
+            if (_PICO_PRINTF_IS(format, "%s")) {
+                return _pico_printf_snprintf_s(buffer, count, __builtin_va_arg_pack());
+            }
+            if (_PICO_PRINTF_IS(format, "%d")) {
+                return _pico_printf_snprintf_d(buffer, count, __builtin_va_arg_pack());
+            }
+            return (snprintf)(buffer, count, format, __builtin_va_arg_pack());
+        }
+
+        static inline __attribute__((always_inline, artificial)) __printflike(2, 3)
+        int _pico_printf_sprintf(char *buffer, const char *format, ...) {
+            const size_t count = __builtin_object_size(buffer, 0);
+            if (_PICO_PRINTF_IS_LITERAL(format)) {
+                return _pico_printf_copy_literal(buffer, count, format);
+            }
+            if (_PICO_PRINTF_IS(format, "%s")) {
+                return _pico_printf_snprintf_s(buffer, count, __builtin_va_arg_pack());
+            }
+            if (_PICO_PRINTF_IS(format, "%d")) {
+                return _pico_printf_snprintf_d(buffer, count, __builtin_va_arg_pack());
+            }
+            return (sprintf)(buffer, format, __builtin_va_arg_pack());
+        }
+
+        #define snprintf(...) _pico_printf_snprintf(__VA_ARGS__)
+        #define sprintf(...) _pico_printf_sprintf(__VA_ARGS__)
+    #endif
 #else
 
     #define weak_raw_printf(...) ({printf(__VA_ARGS__); true;})
@@ -4,23 +4,34 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include <string.h>
+
 #include "pico.h"
 #include "pico/fmt_printf.h"
+#include "pico/fmt_sink.h"
 #include "pico/printf.h"
+#if LIB_PICO_STDIO
+#include "pico/stdio.h"
+#endif
+
+// PICO_CONFIG: PICO_PRINTF_STDOUT_BUFFER_SIZE, Define the size of the on-stack buffer that fmt_stdio_vprintf formats in to before handing the output to pico_stdio, min=1, default=128, group=pico_printf
+#ifndef PICO_PRINTF_STDOUT_BUFFER_SIZE
+#define PICO_PRINTF_STDOUT_BUFFER_SIZE 128
+#endif
 
 #if !PICO_PRINTF_ALWAYS_INCLUDED
 // we don't have a way to specify a truly weak symbol reference (the linker will always include targets in a single link step,
 // so we make a function pointer that is initialized on the first printf called... if printf is not included in the binary
 // (or has never been called - we can't tell) then this will be null. the assumption is that if you are using printf
 // you are likely to have printed something.
-static int (*lazy_vfctprintf)(void (*out)(char character, void *arg), void *arg, const char *format, va_list va);
+static int (*lazy_vprintf)(const char *format, va_list va);
 #endif
 
 // output: [F]un[CT]ion //////////////////////////////////////////////
 
 int vfctprintf(void (*out)(char character, void *arg), void *arg, const char *format, va_list va) {
 #if !PICO_PRINTF_ALWAYS_INCLUDED
-    lazy_vfctprintf = fmt_vfctprintf;
+    lazy_vprintf = fmt_stdio_vprintf;
 #endif
     return fmt_vfctprintf(out, arg, format, va);
 }
@@ -30,7 +41,7 @@ int vfctprintf(void (*out)(char character, void *arg), void *arg, const char *fo
 int WRAPPER_FUNC(vsnprintf)(char *buffer, size_t count, const char *format, va_list va)
 {
 #if !PICO_PRINTF_ALWAYS_INCLUDED
-    lazy_vfctprintf = fmt_vfctprintf;
+    lazy_vprintf = fmt_stdio_vprintf;
 #endif
     return fmt_vsnprintf(buffer, count, format, va);
 }
@@ -52,25 +63,90 @@ int WRAPPER_FUNC(sprintf)(char *buffer, const char *format, ...)
     return ret;
 }
 
+// output: [S]tring, constant formats ////////////////////////////////
+//
+// What <pico/printf.h> turns sprintf()/snprintf() calls with a
+// constant "%s" or "%d" format in to, if
+// PICO_PRINTF_INLINE_CONST_FORMATS.
+
+static int _copy_out(char *buffer, size_t count, const char *str, size_t len) {
+    if (count) {
+        const size_t n = len < count ? len : count - 1;
+        memcpy(buffer, str, n);
+        buffer[n] = '\0';
+    }
+    return (int) len;
+}
+
+int _pico_printf_snprintf_s(char *buffer, size_t count, ...) {
+    va_list va;
+    va_start(va, count);
+    const char *str = va_arg(va, const char *);
+    va_end(va);
+    return _copy_out(buffer, count, str, strlen(str));
+}
+
+int _pico_printf_snprintf_d(char *buffer, size_t count, ...) {
+    va_list va;
+    va_start(va, count);
+    const int value = va_arg(va, int);
+    va_end(va);
+    char buf[11]; // "-2147483648"
+    char *p = &buf[sizeof(buf)];
+    unsigned int u = value < 0 ? 0U - (unsigned int) value : (unsigned int) value;
+    do {
+        *--p = (char) ('0' + u % 10U);
+        u /= 10U;
+    } while (u);
+    if (value < 0) {
+        *--p = '-';
+    }
+    return _copy_out(buffer, count, p, (size_t) (&buf[sizeof(buf)] - p));
+}
+
 // output: stdout ////////////////////////////////////////////////////
 //
 // The main stdout-printf functions are in pico_stdio; these are
-// merely stubs for use by pico_stdio.
-
-#if !PICO_PRINTF_ALWAYS_INCLUDED
+// merely stubs for use by pico_stdio, and a format-then-lock
+// alternative to them.
 
-/**
- * Output a character to a custom device like UART, used by the printf() function
- * This function is declared here only. You have to write your custom implementation somewhere
- * \param character Character to output
- */
-static void _out_char(char character, void *arg) {
-    (void) arg;
-    if (character) {
-        putchar(character);
+static void _stdout_write(struct fmt_sink *self, const char *buf, size_t len) {
+    (void) self;
+    // Like putchar()ing each character, but skip NULs.
+    while (len) {
+        const char *nul = memchr(buf, '\0', len);
+        const size_t n = nul ? (size_t) (nul - buf) : len;
+#if LIB_PICO_STDIO
+        if (n) {
+            stdio_put_string(buf, (int) n, false, true);
+        }
+#else
+        for (size_t i = 0; i < n; i++) {
+            putchar(buf[i]);
+        }
+#endif
+        buf += n + (nul ? 1 : 0);
+        len -= n + (nul ? 1 : 0);
     }
 }
 
+int fmt_stdio_vprintf(const char *format, va_list va) {
+    char buf[PICO_PRINTF_STDOUT_BUFFER_SIZE];
+    struct fmt_sink sink = { .write = _stdout_write };
+    // stdio_put_string() takes the stdout lock itself, for each write.
+    return fmt_vsinkprintf_locked(&sink, NULL, buf, sizeof(buf), format, va);
+}
+
+int fmt_stdio_printf(const char *format, ...) {
+    va_list va;
+    va_start(va, format);
+    const int ret = fmt_stdio_vprintf(format, va);
+    va_end(va);
+    return ret;
+}
+
+#if !PICO_PRINTF_ALWAYS_INCLUDED
+
 bool weak_raw_printf(const char *fmt, ...) {
     va_list va;
     va_start(va, fmt);
@@ -80,8 +156,8 @@ bool weak_raw_printf(const char *fmt, ...) {
 }
 
 bool weak_raw_vprintf(const char *fmt, va_list args) {
-    if (lazy_vfctprintf) {
-        lazy_vfctprintf(_out_char, NULL, fmt, args);
+    if (lazy_vprintf) {
+        lazy_vprintf(fmt, args);
         return true;
     } else {
         puts(fmt);